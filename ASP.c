@@ -4,6 +4,7 @@
 #include <time.h>
 #include <math.h>
 #include <string.h>
+#include "sa.h"
 #define MAX_PARTS 10
 #define MAX_OPERATIONS 100
 #define MAX_TEMP 10000.0
@@ -11,55 +12,62 @@
 #define COOLING_FACTOR 0.95
 #define MAX_ITERATIONS 1000
 
+// Annealing state: operation sequence being improved and best sequence seen
+typedef struct {
+    int operations[MAX_OPERATIONS];
+    int num_operations;
+    int best_solution[MAX_OPERATIONS];
+} SearchState;
+
+// Move: swap two operations
+typedef struct {
+    int index1;
+    int index2;
+} Move;
+
 // Function prototypes
 int calculate_cost(int operations[], int num_operations);
-void generate_initial_solution(int operations[], int num_operations);
-void generate_neighbour_solution(int operations[], int num_operations);
-double acceptance_probability(int cost_current, int cost_neighbour, double temperature);
-
-int main() {
-    srand(time(NULL));
+void generate_initial_solution(int operations[], int num_operations, sa_rng *rng);
+double sequence_cost(void *state, double limit);
+int propose_neighbour(void *state, sa_rng *rng, void *move);
+void swap_operations(void *state, const void *move);
+void save_best_solution(void *state);
+
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
     // Example data: number of operations
     int num_operations = 6;
     int operations[MAX_OPERATIONS];
 
     // Generate initial random solution
-    generate_initial_solution(operations, num_operations);
+    generate_initial_solution(operations, num_operations, &rng);
 
     // Simulated Annealing parameters
-    double temperature = MAX_TEMP;
-    int current_solution[MAX_OPERATIONS];
-    int best_solution[MAX_OPERATIONS];
-    int cost_current, cost_best, cost_neighbour;
-    int iterations = 0;
-
-    // Initial cost calculations
-    cost_current = calculate_cost(operations, num_operations);
-    cost_best = cost_current;
-    memcpy(best_solution, operations, sizeof(int) * num_operations);
-
-    while (temperature > MIN_TEMP && iterations < MAX_ITERATIONS) {
-        generate_neighbour_solution(operations, num_operations);
-        cost_neighbour = calculate_cost(operations, num_operations);
-
-        // Decide if we should accept the neighbour
-        if (acceptance_probability(cost_current, cost_neighbour, temperature) > ((double)rand() / RAND_MAX)) {
-            // Accept the neighbour solution
-            memcpy(current_solution, operations, sizeof(int) * num_operations);
-            cost_current = cost_neighbour;
-
-            // Check if this is the best solution found so far
-            if (cost_current < cost_best) {
-                cost_best = cost_current;
-                memcpy(best_solution, current_solution, sizeof(int) * num_operations);
-            }
-        }
-
-        // Cool down the temperature
-        temperature *= COOLING_FACTOR;
-        iterations++;
-    }
+    sa_params params = {
+        .initial_temperature = MAX_TEMP,
+        .cooling_rate = COOLING_FACTOR,
+        .min_temperature = MIN_TEMP,
+        .max_iterations = MAX_ITERATIONS,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .state_size = sizeof(SearchState),
+        .cost = sequence_cost,
+        .propose = propose_neighbour,
+        .apply = swap_operations,
+        .undo = swap_operations,
+        .save_best = save_best_solution,
+    };
+    SearchState state = {.num_operations = num_operations};
+    memcpy(state.operations, operations, sizeof(int) * num_operations);
+    int cost_best = (int)sa_solve(&problem, &state, &params, &options, &rng, NULL);
+    int *best_solution = state.best_solution;
 
     // Output the best solution found
     printf("Best solution found:\n");
@@ -82,28 +90,40 @@ int calculate_cost(int operations[], int num_operations) {
 }
 
 // Generate an initial random solution
-void generate_initial_solution(int operations[], int num_operations) {
+void generate_initial_solution(int operations[], int num_operations, sa_rng *rng) {
     // Example: randomly generate operations
     for (int i = 0; i < num_operations; i++) {
-        operations[i] = rand() % MAX_PARTS + 1; // Example: operations are parts to be assembled
+        operations[i] = sa_rng_below(rng, MAX_PARTS) + 1; // Example: operations are parts to be assembled
     }
 }
 
-// Generate a neighbour solution (swap two random operations)
-void generate_neighbour_solution(int operations[], int num_operations) {
-    // Example: swap two random operations
-    int index1 = rand() % num_operations;
-    int index2 = rand() % num_operations;
-    int temp = operations[index1];
-    operations[index1] = operations[index2];
-    operations[index2] = temp;
+// Evaluate the current sequence
+double sequence_cost(void *data, double limit) {
+    (void)limit;
+    SearchState *state = data;
+    return calculate_cost(state->operations, state->num_operations);
 }
 
-// Calculate acceptance probability based on current and neighbour costs
-double acceptance_probability(int cost_current, int cost_neighbour, double temperature) {
-    // Example: using a simulated annealing acceptance probability function
-    if (cost_neighbour < cost_current) {
-        return 1.0;
-    }
-    return exp((cost_current - cost_neighbour) / temperature);
+// Generate a neighbour move (swap two random operations)
+int propose_neighbour(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    move->index1 = sa_rng_below(rng, state->num_operations);
+    move->index2 = sa_rng_below(rng, state->num_operations);
+    return 1;
+}
+
+// Swap the two operations of a move (a swap is its own undo)
+void swap_operations(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int temp = state->operations[move->index1];
+    state->operations[move->index1] = state->operations[move->index2];
+    state->operations[move->index2] = temp;
+}
+
+// Record the current sequence as the best one
+void save_best_solution(void *data) {
+    SearchState *state = data;
+    memcpy(state->best_solution, state->operations, sizeof(int) * state->num_operations);
 }
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
 
 #define MAX_TASKS 20
 #define MAX_DAYS 7
@@ -12,14 +13,20 @@
 #define EPSILON 0.001
 
 // Function prototypes
-void generate_initial_solution(int solution[MAX_DAYS][MAX_TASKS], int num_tasks);
+void generate_initial_solution(int solution[MAX_DAYS][MAX_TASKS], int num_tasks, sa_rng *rng);
 int calculate_cost(int solution[MAX_DAYS][MAX_TASKS], int num_tasks);
 void copy_solution(int dest[MAX_DAYS][MAX_TASKS], int src[MAX_DAYS][MAX_TASKS], int num_tasks);
 void print_solution(int solution[MAX_DAYS][MAX_TASKS], int num_tasks);
-double acceptance_probability(int cost, int new_cost, double temperature);
-void simulated_annealing(int solution[MAX_DAYS][MAX_TASKS], int num_tasks);
+void simulated_annealing(int solution[MAX_DAYS][MAX_TASKS], int num_tasks, const sa_options *options, sa_rng *rng);
+
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
-int main() {
     int solution[MAX_DAYS][MAX_TASKS];
     int num_tasks;
 
@@ -32,11 +39,8 @@ int main() {
         return 1;
     }
 
-    // Seed for random number generation
-    srand(time(NULL));
-
     // Generate initial solution randomly
-    generate_initial_solution(solution, num_tasks);
+    generate_initial_solution(solution, num_tasks, &rng);
 
     // Print initial solution
     printf("Initial Solution:\n");
@@ -44,7 +48,7 @@ int main() {
     printf("Cost = %d\n", calculate_cost(solution, num_tasks));
 
     // Apply simulated annealing
-    simulated_annealing(solution, num_tasks);
+    simulated_annealing(solution, num_tasks, &options, &rng);
 
     // Print final solution
     printf("\nOptimal Solution:\n");
@@ -55,10 +59,10 @@ int main() {
 }
 
 // Generate initial solution randomly
-void generate_initial_solution(int solution[MAX_DAYS][MAX_TASKS], int num_tasks) {
+void generate_initial_solution(int solution[MAX_DAYS][MAX_TASKS], int num_tasks, sa_rng *rng) {
     for (int day = 0; day < MAX_DAYS; day++) {
         for (int task = 0; task < num_tasks; task++) {
-            solution[day][task] = rand() % 2; // 0 or 1 representing whether task is scheduled
+            solution[day][task] = sa_rng_below(rng, 2); // 0 or 1 representing whether task is scheduled
         }
     }
 }
@@ -97,57 +101,78 @@ void print_solution(int solution[MAX_DAYS][MAX_TASKS], int num_tasks) {
     }
 }
 
-// Calculate acceptance probability
-double acceptance_probability(int cost, int new_cost, double temperature) {
-    if (new_cost < cost) {
-        return 1.0; // Accept the new solution
-    }
-    return exp((cost - new_cost) / temperature);
-}
-
-// Simulated annealing algorithm
-void simulated_annealing(int solution[MAX_DAYS][MAX_TASKS], int num_tasks) {
+// Annealing state: current and best timetables
+typedef struct {
+    int num_tasks;
     int current_solution[MAX_DAYS][MAX_TASKS];
-    copy_solution(current_solution, solution, num_tasks);
-
     int best_solution[MAX_DAYS][MAX_TASKS];
-    copy_solution(best_solution, solution, num_tasks);
-
-    int current_cost = calculate_cost(current_solution, num_tasks);
-    int best_cost = current_cost;
-
-    double temperature = INITIAL_TEMPERATURE;
-
-    for (int iter = 0; iter < MAX_ITERATIONS && temperature > EPSILON; iter++) {
-        // Generate a neighbor solution (flip a random task on a random day)
-        int day = rand() % MAX_DAYS;
-        int task = rand() % num_tasks;
+} SearchState;
+
+// Move: flip one task on one day
+typedef struct {
+    int day;
+    int task;
+} Move;
+
+// Evaluate the current solution
+double solution_cost(void *data, double limit) {
+    (void)limit;
+    SearchState *state = data;
+    return calculate_cost(state->current_solution, state->num_tasks);
+}
 
-        // Flip the task (0 to 1 or 1 to 0)
-        current_solution[day][task] = 1 - current_solution[day][task];
+// Generate a neighbor move (flip a random task on a random day)
+int propose_flip(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    move->day = sa_rng_below(rng, MAX_DAYS);
+    move->task = sa_rng_below(rng, state->num_tasks);
+    return 1;
+}
 
-        // Calculate the cost of the new solution
-        int new_cost = calculate_cost(current_solution, num_tasks);
+// Flip the task (0 to 1 or 1 to 0); flipping again reverts it
+void flip_task(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    state->current_solution[move->day][move->task] = 1 - state->current_solution[move->day][move->task];
+}
 
-        // Decide whether to accept the new solution
-        double probability = acceptance_probability(current_cost, new_cost, temperature);
+// Record the current solution as the best one
+void save_best_solution(void *data) {
+    SearchState *state = data;
+    copy_solution(state->best_solution, state->current_solution, state->num_tasks);
+}
 
-        if (probability > (double) rand() / RAND_MAX) {
-            // Accept the new solution
-            current_cost = new_cost;
-            if (current_cost < best_cost) {
-                best_cost = current_cost;
-                copy_solution(best_solution, current_solution, num_tasks);
-            }
-        } else {
-            // Revert back to the previous solution
-            current_solution[day][task] = 1 - current_solution[day][task]; // Flip back
-        }
+// Start a restarted chain from a new random timetable
+void restart_solution(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    generate_initial_solution(state->current_solution, state->num_tasks, rng);
+}
 
-        // Cool down the temperature
-        temperature *= COOLING_RATE;
-    }
+// Simulated annealing algorithm
+void simulated_annealing(int solution[MAX_DAYS][MAX_TASKS], int num_tasks, const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    state.num_tasks = num_tasks;
+    copy_solution(state.current_solution, solution, num_tasks);
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMPERATURE,
+        .cooling_rate = COOLING_RATE,
+        .min_temperature = EPSILON,
+        .max_iterations = MAX_ITERATIONS,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .state_size = sizeof(SearchState),
+        .restart = restart_solution,
+        .cost = solution_cost,
+        .propose = propose_flip,
+        .apply = flip_task,
+        .undo = flip_task,
+        .save_best = save_best_solution,
+    };
+    sa_solve(&problem, &state, &params, options, rng, NULL);
 
     // Copy the best solution found
-    copy_solution(solution, best_solution, num_tasks);
+    copy_solution(solution, state.best_solution, num_tasks);
 }
@@ -1,194 +1,270 @@
 // Flexible Job-Shop Scheduling Problem (FJSP)
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
+#include "sa_instance.h"
 
-#define MAX_JOBS 3
-#define MAX_MACHINES 2
-#define MAX_OPERATIONS 10
 #define MAX_ITERATIONS 10000
 
-// Structure definitions
-typedef struct {
-    int job_id;
-    int machine_id;
-    int processing_time;
-} Operation;
-
-typedef struct {
-    int num_operations;
-    Operation operations[MAX_OPERATIONS];
-} Job;
-
 // Global variables
-Job jobs[MAX_JOBS];
+sa_flexible_jobshop instance; // Jobs, operations and the machines each operation can use
 int num_jobs;
 int num_machines;
+int num_operations; // Total number of operations in a solution
 
 // Function prototypes
 void initialize_problem();
-void initialize_solution(int solution[]);
-int calculate_makespan(int solution[]);
-void generate_neighbor(int current_solution[], int neighbor_solution[]);
-double acceptance_probability(int current_makespan, int neighbor_makespan, double temperature);
-void simulated_annealing(int initial_solution[]);
+void initialize_solution(int solution[], sa_rng *rng);
+int calculate_makespan(int solution[], double limit);
+void simulated_annealing(int initial_solution[], const sa_options *options, sa_rng *rng);
 
-int main() {
-    // Initialize random seed
-    srand(time(NULL));
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
     // Initialize problem instance
-    initialize_problem();
+    if (options.instance != NULL) {
+        if (sa_load_flexible_jobshop(options.instance, options.format, options.index, &instance) != 0) {
+            return 1;
+        }
+    } else {
+        initialize_problem();
+    }
+    num_jobs = instance.jobs;
+    num_machines = instance.machines;
+    num_operations = instance.operations;
 
     // Start simulated annealing
-    int initial_solution[MAX_OPERATIONS];
-    initialize_solution(initial_solution);
-    simulated_annealing(initial_solution);
+    int *initial_solution = malloc(num_operations * sizeof(int));
+    initialize_solution(initial_solution, &rng);
+    simulated_annealing(initial_solution, &options, &rng);
 
+    free(initial_solution);
+    sa_free_flexible_jobshop(&instance);
     return 0;
 }
 
 // Function to initialize the FJSP problem instance
 void initialize_problem() {
-    // Example initialization: Define jobs and operations
-    num_jobs = 3; // Example: Three jobs
-    num_machines = 2; // Example: Two machines
-
-    // Example: Job 0 has two operations: (0, 0, 3) and (0, 1, 5) -> Job 0, Machine 0, Processing Time 3
-    jobs[0].num_operations = 2;
-    jobs[0].operations[0] = (Operation){0, 0, 3};
-    jobs[0].operations[1] = (Operation){0, 1, 5};
+    // Example initialization: three jobs on two machines
+    // Job 0 has two operations: operation 0 on machine 0 for 3, operation 1 on machine 1 for 5;
+    // the operations of jobs 1 and 2 can run on either machine
+    int job_start[] = {0, 2, 4, 5};
+    int option_start[] = {0, 1, 2, 4, 6, 8};
+    int option_machine[] = {0, 1, 0, 1, 0, 1, 0, 1};
+    int option_time[] = {3, 5, 4, 6, 2, 3, 6, 4};
 
-    // Similar initialization for other jobs...
+    instance.jobs = 3;
+    instance.machines = 2;
+    instance.operations = 5;
+    instance.job_start = malloc(sizeof(job_start));
+    instance.option_start = malloc(sizeof(option_start));
+    instance.option_machine = malloc(sizeof(option_machine));
+    instance.option_time = malloc(sizeof(option_time));
+    memcpy(instance.job_start, job_start, sizeof(job_start));
+    memcpy(instance.option_start, option_start, sizeof(option_start));
+    memcpy(instance.option_machine, option_machine, sizeof(option_machine));
+    memcpy(instance.option_time, option_time, sizeof(option_time));
 }
 
 // Function to initialize a random initial solution
-void initialize_solution(int solution[]) {
+void initialize_solution(int solution[], sa_rng *rng) {
     // Example: Random permutation of operations
     int index = 0;
     for (int i = 0; i < num_jobs; ++i) {
-        for (int j = 0; j < jobs[i].num_operations; ++j) {
+        for (int j = instance.job_start[i]; j < instance.job_start[i + 1]; ++j) {
             solution[index++] = i; // Assign all operations of job i sequentially
         }
     }
 
     // Randomly shuffle the initial solution
-    for (int i = 0; i < MAX_OPERATIONS; ++i) {
+    for (int i = 0; i < num_operations; ++i) {
         int temp = solution[i];
-        int swap_index = rand() % MAX_OPERATIONS;
+        int swap_index = sa_rng_below(rng, num_operations);
         solution[i] = solution[swap_index];
         solution[swap_index] = temp;
     }
 }
 
 // Function to calculate the makespan of a solution
-int calculate_makespan(int solution[]) {
-    int machine_completion_times[MAX_MACHINES] = {0};
-
-    for (int i = 0; i < MAX_OPERATIONS; ++i) {
-        int job_index = solution[i];
-        for (int j = 0; j < jobs[job_index].num_operations; ++j) {
-            Operation op = jobs[job_index].operations[j];
-            int machine_id = op.machine_id;
-            int processing_time = op.processing_time;
-            machine_completion_times[machine_id] += processing_time;
-        }
+// The k-th occurrence of a job is its k-th operation; each operation starts
+// once its job and machine are free, on the machine where it finishes first.
+// Completion times only grow, so stop once one of them exceeds limit
+int calculate_makespan(int solution[], double limit) {
+    int machine_completion_times[num_machines];
+    int job_completion_times[num_jobs];
+    int next_operation[num_jobs];
+    for (int i = 0; i < num_machines; ++i) {
+        machine_completion_times[i] = 0;
+    }
+    for (int i = 0; i < num_jobs; ++i) {
+        job_completion_times[i] = 0;
+        next_operation[i] = instance.job_start[i];
     }
 
     int max_completion_time = 0;
-    for (int i = 0; i < MAX_MACHINES; ++i) {
-        if (machine_completion_times[i] > max_completion_time) {
-            max_completion_time = machine_completion_times[i];
+    for (int i = 0; i < num_operations; ++i) {
+        int job_index = solution[i];
+        int operation = next_operation[job_index]++;
+        int best_machine = -1;
+        int best_end = 0;
+        for (int k = instance.option_start[operation]; k < instance.option_start[operation + 1]; ++k) {
+            int machine_id = instance.option_machine[k];
+            int start = fmax(job_completion_times[job_index], machine_completion_times[machine_id]);
+            int end = start + instance.option_time[k];
+            if (best_machine < 0 || end < best_end) {
+                best_machine = machine_id;
+                best_end = end;
+            }
+        }
+        machine_completion_times[best_machine] = best_end;
+        job_completion_times[job_index] = best_end;
+        if (best_end > max_completion_time) {
+            max_completion_time = best_end;
+            if (max_completion_time > limit) {
+                break;
+            }
         }
     }
 
     return max_completion_time;
 }
 
-// Function to generate a neighboring solution
-void generate_neighbor(int current_solution[], int neighbor_solution[]) {
-    // Generate a neighbor by swapping two random operations
-    for (int i = 0; i < MAX_OPERATIONS; ++i) {
-        neighbor_solution[i] = current_solution[i];
-    }
+// Annealing state: current solution and best solution
+typedef struct {
+    int *current_solution;
+    int *best_solution;
+} SearchState;
 
-    // Randomly select two indices and swap them
-    int index1 = rand() % MAX_OPERATIONS;
-    int index2 = rand() % MAX_OPERATIONS;
+// Move: swap the operations at two positions
+typedef struct {
+    int index1;
+    int index2;
+} Move;
 
-    int temp = neighbor_solution[index1];
-    neighbor_solution[index1] = neighbor_solution[index2];
-    neighbor_solution[index2] = temp;
+// Function to evaluate the current solution
+double solution_cost(void *data, double limit) {
+    SearchState *state = data;
+    return calculate_makespan(state->current_solution, limit);
 }
 
-// Function to calculate acceptance probability in simulated annealing
-double acceptance_probability(int current_makespan, int neighbor_makespan, double temperature) {
-    if (neighbor_makespan < current_makespan) {
-        return 1.0;
-    } else {
-        return exp(-((double)(neighbor_makespan - current_makespan)) / temperature);
+// Function to pick two different operations to swap
+int propose_swap(void *data, sa_rng *rng, void *move_data) {
+    Move *move = move_data;
+    (void)data;
+    if (num_operations < 2) {
+        return 0;
+    }
+    move->index1 = sa_rng_below(rng, num_operations);
+    move->index2 = sa_rng_below(rng, num_operations);
+    while (move->index1 == move->index2) {
+        move->index2 = sa_rng_below(rng, num_operations);
     }
+    return 1;
 }
 
-// Function implementing simulated annealing
-void simulated_annealing(int initial_solution[]) {
-    int current_solution[MAX_OPERATIONS];
-    int neighbor_solution[MAX_OPERATIONS];
-    double temperature = 100.0;
-    double cooling_rate = 0.99;
-    int current_makespan, neighbor_makespan;
-    int best_solution[MAX_OPERATIONS];
-    int best_makespan;
+// Function to swap two operations in place (a swap is its own undo)
+void swap_operations(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int temp = state->current_solution[move->index1];
+    state->current_solution[move->index1] = state->current_solution[move->index2];
+    state->current_solution[move->index2] = temp;
+}
 
-    // Initialize current solution
-    for (int i = 0; i < MAX_OPERATIONS; ++i) {
-        current_solution[i] = initial_solution[i];
+// Function to record the current solution as the best one
+void save_best_solution(void *data) {
+    SearchState *state = data;
+    for (int i = 0; i < num_operations; ++i) {
+        state->best_solution[i] = state->current_solution[i];
     }
-    current_makespan = calculate_makespan(current_solution);
+}
+
+// Function to allocate the solutions of a search state
+void allocate_state(SearchState *state) {
+    state->current_solution = malloc(num_operations * sizeof(int));
+    state->best_solution = malloc(num_operations * sizeof(int));
+}
 
-    // Initialize best solution
-    for (int i = 0; i < MAX_OPERATIONS; ++i) {
-        best_solution[i] = initial_solution[i];
+// Function to copy the solutions of one search state into another
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    for (int i = 0; i < num_operations; ++i) {
+        to->current_solution[i] = from->current_solution[i];
+        to->best_solution[i] = from->best_solution[i];
     }
-    best_makespan = current_makespan;
-
-    // Simulated Annealing loop
-    int iteration = 0;
-    while (iteration < MAX_ITERATIONS && temperature > 1.0) {
-        // Generate a neighbor solution
-        generate_neighbor(current_solution, neighbor_solution);
-        neighbor_makespan = calculate_makespan(neighbor_solution);
-
-        // Decide whether to move to the neighbor solution
-        double probability = acceptance_probability(current_makespan, neighbor_makespan, temperature);
-        double rand_prob = ((double)rand() / RAND_MAX);
-
-        if (rand_prob < probability) {
-            for (int i = 0; i < MAX_OPERATIONS; ++i) {
-                current_solution[i] = neighbor_solution[i];
-            }
-            current_makespan = neighbor_makespan;
-        }
+}
 
-        // Update the best solution found so far
-        if (current_makespan < best_makespan) {
-            for (int i = 0; i < MAX_OPERATIONS; ++i) {
-                best_solution[i] = current_solution[i];
-            }
-            best_makespan = current_makespan;
-        }
+// Function to copy a search state for a restarted chain
+void *clone_state(const void *data) {
+    SearchState *clone = malloc(sizeof(SearchState));
+    allocate_state(clone);
+    copy_state(clone, data);
+    return clone;
+}
+
+// Function to free the solutions of a search state
+void free_state(SearchState *state) {
+    free(state->current_solution);
+    free(state->best_solution);
+}
 
-        // Cool down the temperature
-        temperature *= cooling_rate;
-        iteration++;
+// Function to free a cloned search state
+void destroy_state(void *data) {
+    free_state(data);
+    free(data);
+}
+
+// Function to start a restarted chain from a new random solution
+void restart_solution(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    initialize_solution(state->current_solution, rng);
+}
+
+// Function implementing simulated annealing
+void simulated_annealing(int initial_solution[], const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    allocate_state(&state);
+
+    // Initialize current solution
+    for (int i = 0; i < num_operations; ++i) {
+        state.current_solution[i] = initial_solution[i];
     }
 
+    sa_params params = {
+        .initial_temperature = 100.0,
+        .cooling_rate = 0.99,
+        .min_temperature = 1.0,
+        .max_iterations = MAX_ITERATIONS,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_solution,
+        .cost = solution_cost,
+        .propose = propose_swap,
+        .apply = swap_operations,
+        .undo = swap_operations,
+        .save_best = save_best_solution,
+    };
+    int best_makespan = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
+
     // Output the best solution found
     printf("Best Makespan found: %d\n", best_makespan);
     printf("Best Solution order:\n");
-    for (int i = 0; i < MAX_OPERATIONS; ++i) {
-        printf("%d ", best_solution[i]);
+    for (int i = 0; i < num_operations; ++i) {
+        printf("%d ", state.best_solution[i]);
     }
     printf("\n");
+    free_state(&state);
 }
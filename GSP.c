@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include "sa.h"
 #define MAX_GROUPS 5
 #define MAX_JOBS 5
 #define INITIAL_TEMP 100.0
@@ -11,25 +12,31 @@
 #define ITERATIONS_PER_TEMP 100
 
 // Function prototypes
-void generate_random_schedule(int schedule[MAX_GROUPS][MAX_JOBS]);
+void generate_random_schedule(int schedule[MAX_GROUPS][MAX_JOBS], sa_rng *rng);
 int calculate_schedule_cost(int schedule[MAX_GROUPS][MAX_JOBS]);
 void copy_schedule(int dest[MAX_GROUPS][MAX_JOBS], int src[MAX_GROUPS][MAX_JOBS]);
 void print_schedule(int schedule[MAX_GROUPS][MAX_JOBS]);
-double acceptance_probability(int energy_diff, double temperature);
-void simulated_annealing(int schedule[MAX_GROUPS][MAX_JOBS]);
+void simulated_annealing(int schedule[MAX_GROUPS][MAX_JOBS], const sa_options *options, sa_rng *rng);
+
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
-int main() {
     int schedule[MAX_GROUPS][MAX_JOBS];
 
     // Generate an initial random schedule
-    generate_random_schedule(schedule);
+    generate_random_schedule(schedule, &rng);
 
     // Print initial schedule
     printf("Initial Schedule:\n");
     print_schedule(schedule);
 
     // Solve using simulated annealing
-    simulated_annealing(schedule);
+    simulated_annealing(schedule, &options, &rng);
 
     // Print final schedule
     printf("\nFinal Schedule:\n");
@@ -39,11 +46,10 @@ int main() {
 }
 
 // Function to generate a random initial schedule
-void generate_random_schedule(int schedule[MAX_GROUPS][MAX_JOBS]) {
-    srand(time(NULL));
+void generate_random_schedule(int schedule[MAX_GROUPS][MAX_JOBS], sa_rng *rng) {
     for (int i = 0; i < MAX_GROUPS; i++) {
         for (int j = 0; j < MAX_JOBS; j++) {
-            schedule[i][j] = rand() % 100; // Random job completion times (assuming some metric for cost)
+            schedule[i][j] = sa_rng_below(rng, 100); // Random job completion times (assuming some metric for cost)
         }
     }
 }
@@ -81,65 +87,73 @@ void print_schedule(int schedule[MAX_GROUPS][MAX_JOBS]) {
     }
 }
 
-// Function to calculate acceptance probability
-double acceptance_probability(int energy_diff, double temperature) {
-    if (energy_diff < 0) {
-        return 1.0;
-    }
-    return exp(-energy_diff / temperature);
+// Annealing state: current and best schedules
+typedef struct {
+    int current_schedule[MAX_GROUPS][MAX_JOBS];
+    int best_schedule[MAX_GROUPS][MAX_JOBS];
+} SearchState;
+
+// Move: swap two jobs in two groups
+typedef struct {
+    int group1, job1;
+    int group2, job2;
+} Move;
+
+// Function to evaluate the current schedule
+double schedule_cost(void *data, double limit) {
+    (void)limit;
+    SearchState *state = data;
+    return calculate_schedule_cost(state->current_schedule);
 }
 
-// Simulated annealing function
-void simulated_annealing(int schedule[MAX_GROUPS][MAX_JOBS]) {
-    int current_schedule[MAX_GROUPS][MAX_JOBS];
-    copy_schedule(current_schedule, schedule);
+// Function to generate a neighboring move (swap two random jobs in two random groups)
+int propose_swap(void *data, sa_rng *rng, void *move_data) {
+    Move *move = move_data;
+    (void)data;
+    move->group1 = sa_rng_below(rng, MAX_GROUPS);
+    move->group2 = sa_rng_below(rng, MAX_GROUPS);
+    move->job1 = sa_rng_below(rng, MAX_JOBS);
+    move->job2 = sa_rng_below(rng, MAX_JOBS);
+    return 1;
+}
 
-    int current_cost = calculate_schedule_cost(current_schedule);
-    int best_cost = current_cost;
-    int best_schedule[MAX_GROUPS][MAX_JOBS];
-    copy_schedule(best_schedule, current_schedule);
-
-    double temperature = INITIAL_TEMP;
-    int iteration = 0;
-
-    while (temperature > MIN_TEMP) {
-        for (int i = 0; i < ITERATIONS_PER_TEMP; i++) {
-            // Generate a neighboring solution (swap two random jobs in two random groups)
-            int group1 = rand() % MAX_GROUPS;
-            int group2 = rand() % MAX_GROUPS;
-            int job1 = rand() % MAX_JOBS;
-            int job2 = rand() % MAX_JOBS;
-
-            // Swap jobs
-            int temp = current_schedule[group1][job1];
-            current_schedule[group1][job1] = current_schedule[group2][job2];
-            current_schedule[group2][job2] = temp;
-
-            // Calculate cost of the new schedule
-            int new_cost = calculate_schedule_cost(current_schedule);
-
-            // Calculate energy difference
-            int cost_diff = new_cost - current_cost;
-
-            // Decide whether to accept the new schedule
-            if (acceptance_probability(cost_diff, temperature) > ((double) rand() / RAND_MAX)) {
-                current_cost = new_cost;
-                if (current_cost < best_cost) {
-                    best_cost = current_cost;
-                    copy_schedule(best_schedule, current_schedule);
-                }
-            } else {
-                // Revert the swap
-                temp = current_schedule[group1][job1];
-                current_schedule[group1][job1] = current_schedule[group2][job2];
-                current_schedule[group2][job2] = temp;
-            }
-        }
-        // Cool the temperature
-        temperature *= COOLING_RATE;
-        iteration++;
-    }
+// Function to swap the jobs of a move (a swap is its own undo)
+void swap_jobs(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int temp = state->current_schedule[move->group1][move->job1];
+    state->current_schedule[move->group1][move->job1] = state->current_schedule[move->group2][move->job2];
+    state->current_schedule[move->group2][move->job2] = temp;
+}
+
+// Function to record the current schedule as the best one
+void save_best_schedule(void *data) {
+    SearchState *state = data;
+    copy_schedule(state->best_schedule, state->current_schedule);
+}
+
+// Simulated annealing function
+void simulated_annealing(int schedule[MAX_GROUPS][MAX_JOBS], const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    copy_schedule(state.current_schedule, schedule);
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMP,
+        .cooling_rate = COOLING_RATE,
+        .min_temperature = MIN_TEMP,
+        .iterations_per_temperature = ITERATIONS_PER_TEMP,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .state_size = sizeof(SearchState),
+        .cost = schedule_cost,
+        .propose = propose_swap,
+        .apply = swap_jobs,
+        .undo = swap_jobs,
+        .save_best = save_best_schedule,
+    };
+    sa_solve(&problem, &state, &params, options, rng, NULL);
 
     // Copy the best schedule found back to the original schedule
-    copy_schedule(schedule, best_schedule);
+    copy_schedule(schedule, state.best_schedule);
 }
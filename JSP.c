@@ -1,8 +1,13 @@
 // Job-Shop Scheduling Problem (JSP)
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
+#include <limits.h>
+#include "sa.h"
+#include "sa_instance.h"
+#include "sa_arena.h"
 // Define structures
 typedef struct {
     int machine;
@@ -15,17 +20,25 @@ typedef struct {
 // Global variables
 int num_jobs = 3;
 int num_machines = 3;
-Job jobs[3];
+Job *jobs;
+// Operations are numbered flat: operation j of job i is operation_offset[i] + j
+int *operation_offset;
+int total_operations;
+int *operation_job;      // Job of each operation
+int *operation_machine;  // Machine of each operation, from 0
+int *operation_duration;
+// A solution lists the operations of each machine in processing order:
+// machine k runs order[machine_start[k] .. machine_start[k + 1] - 1]
+int *machine_start;
 // Function prototypes
 void initialize_data();
-void initialize_schedule(int **schedule);
-int calculate_makespan(int **schedule);
-void copy_schedule(int **source, int **destination);
-void free_memory(int **schedule);
-void simulated_annealing();
+int load_data(const char *path, const char *format, int index);
+void index_operations();
+void simulated_annealing(const sa_options *options, sa_rng *rng);
 // Function to initialize data (hardcoded for demonstration)
 void initialize_data() {
     // Example data initialization
+    jobs = (Job *)malloc(num_jobs * sizeof(Job));
     jobs[0].num_operations = 2;
     jobs[0].operations = (Operation *)malloc(2 * sizeof(Operation));
 jobs[0].operations[0].machine = 1;
@@ -45,129 +58,470 @@ jobs[2].operations[0].duration = 1;
 jobs[2].operations[1].machine = 3;
 jobs[2].operations[1].duration = 2;
 }
-// Function to initialize a schedule randomly
-void initialize_schedule(int **schedule) {
+// Function to load a job shop instance (machines are numbered from 1 here)
+int load_data(const char *path, const char *format, int index) {
+    sa_jobshop instance;
+    if (sa_load_jobshop(path, format, index, &instance) != 0) {
+        return -1;
+    }
+    num_jobs = instance.jobs;
+    num_machines = instance.machines;
+    jobs = (Job *)malloc(num_jobs * sizeof(Job));
     for (int i = 0; i < num_jobs; i++) {
-        for (int j = 0; j < jobs[i].num_operations; j++) {
-            schedule[i][j + 1] = rand() % num_machines + 1; // Randomly assign machines
+        jobs[i].num_operations = num_machines;
+        jobs[i].operations = (Operation *)malloc(num_machines * sizeof(Operation));
+        for (int j = 0; j < num_machines; j++) {
+            jobs[i].operations[j].machine = instance.machine[i * num_machines + j] + 1;
+            jobs[i].operations[j].duration = instance.time[i * num_machines + j];
         }
     }
+    sa_free_jobshop(&instance);
+    return 0;
 }
-// Function to calculate makespan of a schedule
-int calculate_makespan(int **schedule) {
-    int *machine_end_times = (int *)malloc(num_machines * sizeof(int));
-    for (int i = 0; i < num_machines; i++) {
-        machine_end_times[i] = 0;
+// Function to lay out the operations of all jobs in one flat array and
+// size the machine sequences
+void index_operations() {
+    operation_offset = (int *)malloc((num_jobs + 1) * sizeof(int));
+    total_operations = 0;
+    for (int i = 0; i < num_jobs; i++) {
+        operation_offset[i] = total_operations;
+        total_operations += jobs[i].num_operations;
     }
+    operation_offset[num_jobs] = total_operations;
+    operation_job = (int *)malloc(total_operations * sizeof(int));
+    operation_machine = (int *)malloc(total_operations * sizeof(int));
+    operation_duration = (int *)malloc(total_operations * sizeof(int));
+    machine_start = (int *)calloc(num_machines + 1, sizeof(int));
     for (int i = 0; i < num_jobs; i++) {
-        int job_end_time = 0;
         for (int j = 0; j < jobs[i].num_operations; j++) {
-            int current_machine = schedule[i][j + 1] - 1; // machine index
-            int current_duration = jobs[i].operations[j].duration;
-            int start_time = machine_end_times[current_machine];
-            int end_time = start_time + current_duration;
-            if (end_time > job_end_time) {
-                job_end_time = end_time;
-            }
-    machine_end_times[current_machine] = end_time;
+            int operation = operation_offset[i] + j;
+            operation_job[operation] = i;
+            operation_machine[operation] = jobs[i].operations[j].machine - 1;
+            operation_duration[operation] = jobs[i].operations[j].duration;
+            machine_start[operation_machine[operation] + 1]++;
         }
     }
-
-    int makespan = 0;
-    for (int i = 0; i < num_machines; i++) {
-        if (machine_end_times[i] > makespan) {
-            makespan = machine_end_times[i];
-        }
+    for (int k = 0; k < num_machines; k++) {
+        machine_start[k + 1] += machine_start[k];
     }
-    free(machine_end_times);
-    return makespan;
 }
-// Function to copy one schedule to another
-void copy_schedule(int **source, int **destination) {
-    for (int i = 0; i < num_jobs; i++) {
-        for (int j = 0; j <= jobs[i].num_operations; j++) {
-            destination[i][j] = source[i][j];
-        }
+// Function to find the previous operation of the same job (-1 for the first)
+static inline int job_predecessor(int operation) {
+    return operation > operation_offset[operation_job[operation]] ? operation - 1 : -1;
+}
+// Function to find the next operation of the same job (-1 for the last)
+static inline int job_successor(int operation) {
+    return operation + 1 < operation_offset[operation_job[operation] + 1] ? operation + 1 : -1;
+}
+// Annealing state, carved from one arena per chain: the machine sequences
+// (order, with the position of every operation in it), the best sequences
+// seen, and the disjunctive graph of the current solution. heads[o] is the
+// earliest start of operation o and tails[o] the longest path from its end
+// to the end of the schedule; an operation is critical when heads + duration
+// + tails equals the makespan. One critical path is kept, split into blocks:
+// runs of two or more consecutive operations on the same machine.
+typedef struct {
+    sa_arena arena;
+    int *order;
+    int *position;
+    int *best_order;
+    int *heads;
+    int *tails;
+    int *trial_heads;   // Heads of the moved operations in a neighbour being evaluated
+    int *topological;   // Operations in the order the decoder scheduled them
+    int *pending;       // Unscheduled predecessors of each operation
+    int *path;          // Critical path, from the first operation to the last
+    int *block_start;   // Index in path of the first operation of each block
+    int *block_length;
+    int path_length;
+    int blocks;
+    int makespan;
+} SearchState;
+// Move: take the operation at position from in order out and reinsert it at
+// position to, on the same machine (from == to changes nothing)
+typedef struct {
+    int from;
+    int to;
+} Move;
+// Function to allocate the buffers of a search state in one block
+void allocate_state(SearchState *state) {
+    size_t size = total_operations * sizeof(int);
+    sa_arena_init(&state->arena, 11 * sa_arena_size(size));
+    state->order = sa_arena_alloc(&state->arena, size);
+    state->position = sa_arena_alloc(&state->arena, size);
+    state->best_order = sa_arena_alloc(&state->arena, size);
+    state->heads = sa_arena_alloc(&state->arena, size);
+    state->tails = sa_arena_alloc(&state->arena, size);
+    state->trial_heads = sa_arena_alloc(&state->arena, size);
+    state->topological = sa_arena_alloc(&state->arena, size);
+    state->pending = sa_arena_alloc(&state->arena, size);
+    state->path = sa_arena_alloc(&state->arena, size);
+    state->block_start = sa_arena_alloc(&state->arena, size);
+    state->block_length = sa_arena_alloc(&state->arena, size);
+}
+// Function to find the previous operation on the same machine (-1 for the first)
+static inline int machine_predecessor(const SearchState *state, int operation) {
+    int index = state->position[operation];
+    return index > machine_start[operation_machine[operation]] ? state->order[index - 1] : -1;
+}
+// Function to find the next operation on the same machine (-1 for the last)
+static inline int machine_successor(const SearchState *state, int operation) {
+    int index = state->position[operation];
+    return index + 1 < machine_start[operation_machine[operation] + 1] ? state->order[index + 1] : -1;
+}
+// Function to recompute the positions of order[first .. last]
+void index_positions(SearchState *state, int first, int last) {
+    for (int i = first; i <= last; i++) {
+        state->position[state->order[i]] = i;
     }
 }
-// Function to free memory allocated for a schedule
-void free_memory(int **schedule) {
+// Function to build a random solution: repeatedly pick a job with operations
+// left and append its next operation to its machine. The sequences follow
+// one order of all operations, so the disjunctive graph has no cycle.
+void initialize_schedule(SearchState *state, sa_rng *rng) {
+    int next[num_jobs], unfinished[num_jobs], fill[num_machines];
+    int remaining = 0;
     for (int i = 0; i < num_jobs; i++) {
-        free(schedule[i]);
+        next[i] = operation_offset[i];
+        if (jobs[i].num_operations > 0) {
+            unfinished[remaining++] = i;
+        }
     }
-    free(schedule);
+    for (int k = 0; k < num_machines; k++) {
+        fill[k] = machine_start[k];
+    }
+    while (remaining > 0) {
+        int pick = sa_rng_below(rng, remaining);
+        int job = unfinished[pick];
+        int operation = next[job]++;
+        state->order[fill[operation_machine[operation]]++] = operation;
+        if (next[job] == operation_offset[job + 1]) {
+            unfinished[pick] = unfinished[--remaining];
+        }
+    }
+    index_positions(state, 0, total_operations - 1);
 }
-// Simulated Annealing function
-void simulated_annealing() {
-    initialize_data();
-    // Initialize the best schedule found
-    int **best_schedule = (int **)malloc(num_jobs * sizeof(int *));
-    for (int i = 0; i < num_jobs; i++) {
-        best_schedule[i] = (int *)malloc((jobs[i].num_operations + 1) * sizeof(int));
+// Function to move the operation at position from to position to, shifting
+// the operations in between; positions are kept up to date
+void move_operation(SearchState *state, int from, int to) {
+    int operation = state->order[from];
+    if (from < to) {
+        memmove(&state->order[from], &state->order[from + 1], (to - from) * sizeof(int));
+    } else {
+        memmove(&state->order[to + 1], &state->order[to], (from - to) * sizeof(int));
     }
-    int **current_schedule = (int **)malloc(num_jobs * sizeof(int *));
-    for (int i = 0; i < num_jobs; i++) {
-        current_schedule[i] = (int *)malloc((jobs[i].num_operations + 1) * sizeof(int));
+    state->order[to] = operation;
+    index_positions(state, from < to ? from : to, from < to ? to : from);
+}
+// Function to compute the heads of all operations in topological order of
+// the disjunctive graph (job arcs plus the machine sequences) and return the
+// makespan. Returns INT_MAX when the sequences contain a cycle, and stops
+// with a value above limit once an operation ends after it.
+int calculate_makespan(SearchState *state, int *heads, double limit) {
+    int scheduled = 0, queued = 0;
+    for (int o = 0; o < total_operations; o++) {
+        state->pending[o] = (job_predecessor(o) >= 0) + (machine_predecessor(state, o) >= 0);
+        if (state->pending[o] == 0) {
+            state->topological[queued++] = o;
+        }
     }
-initialize_schedule(current_schedule);
-copy_schedule(current_schedule, best_schedule);
-    int current_makespan = calculate_makespan(current_schedule);
-    int best_makespan = current_makespan;
-    // Simulated Annealing parameters
-    double temperature = 1000.0;
-    double cooling_rate = 0.95;
-    while (temperature > 1.0) {
-        // Generate a neighboring solution
-        int job1 = rand() % num_jobs;
-        int job2 = rand() % num_jobs;
-        while (job1 == job2) {
-            job2 = rand() % num_jobs;
-        }
-        int op1 = rand() % jobs[job1].num_operations;
-        int op2 = rand() % jobs[job2].num_operations;
-        // Swap operations
-        int temp = current_schedule[job1][op1 + 1];
-        current_schedule[job1][op1 + 1] = current_schedule[job2][op2 + 1];
-        current_schedule[job2][op2 + 1] = temp;
-        // Calculate new makespan
-        int new_makespan = calculate_makespan(current_schedule);
-        // Calculate difference in makespan
-        int delta_makespan = new_makespan - current_makespan;
-        // Decide whether to move to the new solution
-        if (delta_makespan < 0 || exp(-delta_makespan / temperature) > ((double)rand() / RAND_MAX)) {
-            current_makespan = new_makespan;
-            if (current_makespan < best_makespan) {
-                best_makespan = current_makespan;
-                copy_schedule(current_schedule, best_schedule);
+    int makespan = 0;
+    while (scheduled < queued) {
+        int o = state->topological[scheduled++];
+        int job = job_predecessor(o), machine = machine_predecessor(state, o);
+        int start = job >= 0 ? heads[job] + operation_duration[job] : 0;
+        if (machine >= 0 && heads[machine] + operation_duration[machine] > start) {
+            start = heads[machine] + operation_duration[machine];
+        }
+        heads[o] = start;
+        int end = start + operation_duration[o];
+        if (end > makespan) {
+            makespan = end;
+            if (makespan > limit) {
+                return makespan;
             }
+        }
+        int successors[2] = {job_successor(o), machine_successor(state, o)};
+        for (int s = 0; s < 2; s++) {
+            if (successors[s] >= 0 && --state->pending[successors[s]] == 0) {
+                state->topological[queued++] = successors[s];
+            }
+        }
+    }
+    return scheduled == total_operations ? makespan : INT_MAX;
+}
+// Function to decode the current solution: heads, tails, makespan and one
+// critical path split into blocks
+void refresh_state(SearchState *state) {
+    state->makespan = calculate_makespan(state, state->heads, INFINITY);
+    int end = -1;
+    for (int i = total_operations - 1; i >= 0; i--) {
+        int o = state->topological[i];
+        int job = job_successor(o), machine = machine_successor(state, o);
+        int tail = job >= 0 ? operation_duration[job] + state->tails[job] : 0;
+        if (machine >= 0 && operation_duration[machine] + state->tails[machine] > tail) {
+            tail = operation_duration[machine] + state->tails[machine];
+        }
+        state->tails[o] = tail;
+        if (tail == 0 && state->heads[o] + operation_duration[o] == state->makespan) {
+            end = o;
+        }
+    }
+    // Walk back from the last operation through the predecessors that
+    // determine each head, preferring the machine arc
+    int length = 0;
+    for (int o = end; o >= 0;) {
+        state->path[length++] = o;
+        int machine = machine_predecessor(state, o), job = job_predecessor(o);
+        if (machine >= 0 && state->heads[machine] + operation_duration[machine] == state->heads[o]) {
+            o = machine;
+        } else if (job >= 0 && state->heads[job] + operation_duration[job] == state->heads[o]) {
+            o = job;
         } else {
-            // Revert to the previous solution
-        current_schedule[job2][op2 + 1] = current_schedule[job1][op1 + 1];
-            current_schedule[job1][op1 + 1] = temp;
+            o = -1;
+        }
+    }
+    for (int i = 0; i < length / 2; i++) {
+        int temp = state->path[i];
+        state->path[i] = state->path[length - 1 - i];
+        state->path[length - 1 - i] = temp;
+    }
+    state->path_length = length;
+    state->blocks = 0;
+    for (int i = 0; i < length;) {
+        int j = i + 1;
+        while (j < length && machine_successor(state, state->path[j - 1]) == state->path[j]) {
+            j++;
+        }
+        if (j - i >= 2) {
+            state->block_start[state->blocks] = i;
+            state->block_length[state->blocks] = j - i;
+            state->blocks++;
+        }
+        i = j;
+    }
+}
+// Function to evaluate the current solution (in full, so that the graph
+// kept for proposing moves is complete)
+double schedule_cost(void *data, double limit) {
+    SearchState *state = data;
+    (void)limit;
+    refresh_state(state);
+    return state->makespan;
+}
+// Function to pick a move on a critical block (N6 of Balas and
+// Vazacopoulos, 1998): an operation of the block is moved right after its
+// last operation or right before its first. Such a move keeps the graph
+// acyclic when the tails (forward moves) or heads (backward moves) say so;
+// otherwise the operation only swaps with its neighbour in the block, which
+// is always safe (van Laarhoven et al., 1992). Swapping the two operations
+// at either end of a block are the N5 moves of Nowicki and Smutnicki (1996).
+// Moves off the critical path cannot shorten it and are never proposed.
+// Without a block there is no move: every critical arc is a job arc, so the
+// makespan is a job's length and the solution is optimal.
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    if (state->blocks == 0) {
+        return 0;
+    }
+    int block = sa_rng_below(rng, state->blocks);
+    const int *operations = &state->path[state->block_start[block]];
+    int length = state->block_length[block];
+    int pick = sa_rng_below(rng, 2 * (length - 1));
+    if (pick < length - 1) {
+        // Forward: operations[pick] goes after the last operation of the block
+        int u = operations[pick], v = operations[length - 1];
+        int next = job_successor(u);
+        if (pick + 2 < length && next >= 0 &&
+            operation_duration[v] + state->tails[v] < operation_duration[next] + state->tails[next]) {
+            v = operations[pick + 1];
+        }
+        move->from = state->position[u];
+        move->to = state->position[v];
+    } else {
+        // Backward: operations[pick] goes before the first operation of the block
+        pick = pick - (length - 1) + 1;
+        int u = operations[0], v = operations[pick];
+        int previous = job_predecessor(v);
+        if (pick > 1 && previous >= 0 &&
+            state->heads[u] + operation_duration[u] < state->heads[previous] + operation_duration[previous]) {
+            u = operations[pick - 1];
+        }
+        move->from = state->position[v];
+        move->to = state->position[u];
+    }
+    return 1;
+}
+// Function to find the operation at position index of order once the move
+// is made, for index between from and to
+static inline int moved_operation(const SearchState *state, const Move *move, int index) {
+    if (move->from < move->to) {
+        return index < move->to ? state->order[index + 1] : state->order[move->from];
+    }
+    return index > move->to ? state->order[index - 1] : state->order[move->from];
+}
+// Function to estimate the makespan after a move from the heads and tails of
+// the current solution (Taillard, 1994; Dell'Amico and Trubian, 1993). Only
+// the operations between from and to change places: their new heads follow
+// from the machine predecessor of the segment and their job predecessors,
+// their new tails from the machine successor of the segment and their job
+// successors, and the estimate is the longest path through any of them.
+// This takes O(to - from) instead of a decode of the whole graph.
+double move_cost(void *data, const void *move_data, double limit) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    (void)limit;
+    if (move->from == move->to) {
+        return state->makespan;
+    }
+    int first = move->from < move->to ? move->from : move->to;
+    int last = move->from < move->to ? move->to : move->from;
+    int machine = operation_machine[state->order[first]];
+    int ready = 0;
+    if (first > machine_start[machine]) {
+        int before = state->order[first - 1];
+        ready = state->heads[before] + operation_duration[before];
+    }
+    for (int i = first; i <= last; i++) {
+        int o = moved_operation(state, move, i);
+        int job = job_predecessor(o);
+        if (job >= 0 && state->heads[job] + operation_duration[job] > ready) {
+            ready = state->heads[job] + operation_duration[job];
         }
-        // Cooling process
-        temperature *= cooling_rate;
+        state->trial_heads[o] = ready;
+        ready += operation_duration[o];
     }
-    // Output the best schedule found
-    printf("Best MakespanMakespan = %d\n", best_makespan);
-    printf("Best Schedule:\n");
+    int following = 0, estimate = 0;
+    if (last + 1 < machine_start[machine + 1]) {
+        int after = state->order[last + 1];
+        following = operation_duration[after] + state->tails[after];
+    }
+    for (int i = last; i >= first; i--) {
+        int o = moved_operation(state, move, i);
+        int job = job_successor(o);
+        if (job >= 0 && operation_duration[job] + state->tails[job] > following) {
+            following = operation_duration[job] + state->tails[job];
+        }
+        if (state->trial_heads[o] + operation_duration[o] + following > estimate) {
+            estimate = state->trial_heads[o] + operation_duration[o] + following;
+        }
+        following += operation_duration[o];
+    }
+    return estimate;
+}
+// Function to apply an accepted move (the engine then decodes the new
+// solution through schedule_cost)
+void apply_move(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    move_operation(state, move->from, move->to);
+}
+// Function to record the current solution as the best one
+void save_best_schedule(void *data) {
+    SearchState *state = data;
+    memcpy(state->best_order, state->order, total_operations * sizeof(int));
+}
+// Function to copy the solutions of one search state into another
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    memcpy(to->order, from->order, total_operations * sizeof(int));
+    memcpy(to->best_order, from->best_order, total_operations * sizeof(int));
+    index_positions(to, 0, total_operations - 1);
+    refresh_state(to);
+}
+// Function to copy a search state for a restarted chain
+void *clone_state(const void *data) {
+    SearchState *clone = malloc(sizeof(SearchState));
+    allocate_state(clone);
+    copy_state(clone, data);
+    return clone;
+}
+// Function to free a cloned search state
+void destroy_state(void *data) {
+    SearchState *state = data;
+    sa_arena_free(&state->arena);
+    free(state);
+}
+// Function to start a restarted chain from a new random schedule
+void restart_schedule(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    initialize_schedule(state, rng);
+}
+// Simulated Annealing function
+void simulated_annealing(const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    allocate_state(&state);
+    initialize_schedule(&state, rng);
+    // Simulated Annealing parameters
+    sa_params params = {
+        .initial_temperature = 100.0,
+        .cooling_rate = 0.95,
+        .min_temperature = 1.0,
+        .iterations_per_temperature = 1000,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .estimated = 1,
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_schedule,
+        .cost = schedule_cost,
+        .propose = propose_move,
+        .evaluate = move_cost,
+        .apply = apply_move,
+        .save_best = save_best_schedule,
+    };
+    int best_makespan = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
+    // Output the best schedule found: machine and start time of each operation
+    memcpy(state.order, state.best_order, total_operations * sizeof(int));
+    index_positions(&state, 0, total_operations - 1);
+    refresh_state(&state);
+    printf("Best Makespan = %d\n", best_makespan);
+    printf("Best Schedule (machine, start):\n");
     for (int i = 0; i < num_jobs; i++) {
         printf("Job %d: ", i + 1);
         for (int j = 0; j < jobs[i].num_operations; j++) {
-            printf("(%d,%d) ", best_schedule[i][j + 1], jobs[i].operations[j].duration);
+            int operation = operation_offset[i] + j;
+            printf("(%d,%d) ", operation_machine[operation] + 1, state.heads[operation]);
         }
         printf("\n");
     }
     // Free allocated memory
-    free_memory(best_schedule);
-free_memory(current_schedule);
+    sa_arena_free(&state.arena);
+    free(machine_start);
+    free(operation_duration);
+    free(operation_machine);
+    free(operation_job);
+    free(operation_offset);
     for (int i = 0; i < num_jobs; i++) {
     free(jobs[i].operations);
     }
+    free(jobs);
 }
 // Main function
-int main() {
-    srand(time(NULL));
-    simulated_annealing();
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
+    if (options.instance != NULL) {
+        if (load_data(options.instance, options.format, options.index) != 0) {
+            return 1;
+        }
+    } else {
+        initialize_data();
+    }
+    if (num_jobs < 2) {
+        fprintf(stderr, "JSP needs at least two jobs\n");
+        return 1;
+    }
+    index_operations();
+    simulated_annealing(&options, &rng);
     return 0;
 }
\ No newline at end of file
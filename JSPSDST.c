@@ -1,23 +1,27 @@
 // Job-Shop Scheduling Problem with Sequence Dependent Setup Times (JSPSDST)
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <time.h>
 #include <math.h>
+#include "sa.h"
+#include "sa_instance.h"
+#include "sa_arena.h"
 
-#define MAX_JOBS 10
-#define MAX_MACHINES 10
-
-// Example problem constants
-const int num_jobs = 5;
-const int num_machines = 5;
-int processing_times[MAX_JOBS][MAX_MACHINES] = {
+// Example problem: 5 jobs on 5 machines, job i visits machine (i + j) % 5 as
+// its j-th operation
+#define EXAMPLE_JOBS 5
+#define EXAMPLE_MACHINES 5
+int processing_times[EXAMPLE_JOBS][EXAMPLE_MACHINES] = {
     {5, 7, 3, 6, 4},
     {6, 4, 7, 3, 5},
     {4, 5, 6, 3, 7},
     {3, 6, 5, 4, 7},
     {5, 4, 3, 6, 7}
 };
-int setup_times[MAX_MACHINES][MAX_MACHINES] = {
+// Setup between two consecutive jobs on a machine, the same on every machine
+int setup_times[EXAMPLE_JOBS][EXAMPLE_JOBS] = {
     {0, 3, 2, 4, 3},
     {3, 0, 1, 2, 4},
     {2, 1, 0, 3, 2},
@@ -25,124 +29,574 @@ int setup_times[MAX_MACHINES][MAX_MACHINES] = {
     {3, 4, 2, 1, 0}
 };
 
-// Function prototypes
-void generate_initial_solution(int current_solution[]);
-int calculate_makespan(int solution[]);
-void copy_solution(int dest[], int src[]);
-void simulated_annealing(int current_solution[], int best_solution[]);
-
-int main() {
-    srand(time(NULL));
-
-    int current_solution[MAX_JOBS * MAX_MACHINES];
-    int best_solution[MAX_JOBS * MAX_MACHINES];
+// Problem instance. Operation j of job i is operation i * num_machines + j
+// and runs on instance.shop.machine[o] for instance.shop.time[o].
+sa_setup_jobshop instance;
+int num_jobs;
+int num_machines;
+int num_operations;
+// A solution lists the operations of each machine in processing order:
+// machine k runs order[k * num_jobs .. (k + 1) * num_jobs - 1]
+int *machine_start;
 
-    generate_initial_solution(current_solution);
-    copy_solution(best_solution, current_solution);
+// Function prototypes
+void build_example();
+int index_machines();
+void simulated_annealing(const sa_options *options, sa_rng *rng);
 
-    simulated_annealing(current_solution, best_solution);
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
-    printf("Best Solution Sequence:\n");
-    for (int i = 0; i < num_jobs * num_machines; ++i) {
-        printf("%d ", best_solution[i]);
+    if (options.instance != NULL) {
+        if (sa_load_setup_jobshop(options.instance, options.format, options.index, &instance) != 0) {
+            return 1;
+        }
+    } else {
+        build_example();
+    }
+    if (index_machines() != 0) {
+        fprintf(stderr, "JSPSDST needs every job to visit every machine once\n");
+        return 1;
     }
-    printf("\n");
 
-    printf("Best Makespan: %d\n", calculate_makespan(best_solution));
+    simulated_annealing(&options, &rng);
 
+    free(machine_start);
+    sa_free_setup_jobshop(&instance);
     return 0;
 }
 
-void generate_initial_solution(int current_solution[]) {
-    // Generate a random initial solution (random permutation of machine orders)
-    int machines[MAX_MACHINES];
-    for (int i = 0; i < num_machines; ++i) {
-        machines[i] = i;
+void build_example() {
+    int n = EXAMPLE_JOBS, m = EXAMPLE_MACHINES;
+    instance.shop.jobs = n;
+    instance.shop.machines = m;
+    instance.shop.machine = malloc(n * m * sizeof(int));
+    instance.shop.time = malloc(n * m * sizeof(int));
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < m; ++j) {
+            int machine = (i + j) % m;
+            instance.shop.machine[i * m + j] = machine;
+            instance.shop.time[i * m + j] = processing_times[i][machine];
+        }
     }
+    instance.stride = (n + SA_SETUP_ALIGN - 1) / SA_SETUP_ALIGN * SA_SETUP_ALIGN;
+    instance.setup = aligned_alloc(64, m * n * instance.stride * sizeof(int16_t));
+    for (int k = 0; k < m; ++k) {
+        for (int a = 0; a < n; ++a) {
+            for (int b = 0; b < instance.stride; ++b) {
+                instance.setup[(k * n + a) * instance.stride + b] = b < n ? setup_times[a][b] : 0;
+            }
+        }
+    }
+}
 
+// Check that each job visits each machine once and lay out the machine sequences
+int index_machines() {
+    num_jobs = instance.shop.jobs;
+    num_machines = instance.shop.machines;
+    num_operations = num_jobs * num_machines;
     for (int i = 0; i < num_jobs; ++i) {
-        // Randomly shuffle machine order for each job
+        int seen[num_machines];
+        memset(seen, 0, sizeof(seen));
         for (int j = 0; j < num_machines; ++j) {
-            int k = rand() % num_machines;
-            int temp = machines[j];
-            machines[j] = machines[k];
-            machines[k] = temp;
+            if (seen[instance.shop.machine[i * num_machines + j]]++) {
+                return -1;
+            }
         }
+    }
+    machine_start = malloc((num_machines + 1) * sizeof(int));
+    for (int k = 0; k <= num_machines; ++k) {
+        machine_start[k] = k * num_jobs;
+    }
+    return 0;
+}
 
-        // Copy shuffled machine order into current solution
-        for (int j = 0; j < num_machines; ++j) {
-            current_solution[i * num_machines + j] = machines[j];
+static inline int job_of(int operation) {
+    return operation / num_machines;
+}
+
+static inline int duration(int operation) {
+    return instance.shop.time[operation];
+}
+
+static inline int machine_of(int operation) {
+    return instance.shop.machine[operation];
+}
+
+// Setup on the machine of both operations when next directly follows previous
+static inline int setup(int previous, int next) {
+    const int16_t *row = &instance.setup[((size_t)machine_of(previous) * num_jobs + job_of(previous)) * instance.stride];
+    return row[job_of(next)];
+}
+
+static inline int job_predecessor(int operation) {
+    return operation % num_machines > 0 ? operation - 1 : -1;
+}
+
+static inline int job_successor(int operation) {
+    return (operation + 1) % num_machines > 0 ? operation + 1 : -1;
+}
+
+// Annealing state, carved from one arena per chain: the machine sequences
+// (order, with the position of every operation in it), the best sequences
+// seen, and the disjunctive graph of the current solution, where a machine
+// arc from a to b weighs duration(a) + setup(a, b). heads[o] is the earliest
+// start of o, tails[o] the longest path from its end to the end of the
+// schedule; topological lists the operations in an order the graph allows
+// and rank[o] is the place of o in it. One critical path is kept, split
+// into blocks of two or more consecutive operations on the same machine.
+typedef struct {
+    sa_arena arena;
+    int *order;
+    int *position;
+    int *best_order;
+    int *heads;
+    int *tails;
+    int *topological;
+    int *rank;
+    int *pending;        // Unscheduled predecessors of each operation (decoder scratch)
+    int *trial_heads;    // Heads and tails of the moved operations in a neighbour being evaluated
+    int *trial_tails;
+    int *path;           // Critical path, from the first operation to the last
+    int *block_start;    // Index in path of the first operation of each block
+    int *block_length;
+    int blocks;
+    int makespan;
+    int decoded;         // heads, tails and path describe order
+} SearchState;
+
+// Move: take the operation at position from in order out and reinsert it at
+// position to, on the same machine (from == to changes nothing)
+typedef struct {
+    int from;
+    int to;
+} Move;
+
+void allocate_state(SearchState *state) {
+    size_t size = num_operations * sizeof(int);
+    sa_arena_init(&state->arena, 13 * sa_arena_size(size));
+    state->order = sa_arena_alloc(&state->arena, size);
+    state->position = sa_arena_alloc(&state->arena, size);
+    state->best_order = sa_arena_alloc(&state->arena, size);
+    state->heads = sa_arena_alloc(&state->arena, size);
+    state->tails = sa_arena_alloc(&state->arena, size);
+    state->topological = sa_arena_alloc(&state->arena, size);
+    state->rank = sa_arena_alloc(&state->arena, size);
+    state->pending = sa_arena_alloc(&state->arena, size);
+    state->trial_heads = sa_arena_alloc(&state->arena, size);
+    state->trial_tails = sa_arena_alloc(&state->arena, size);
+    state->path = sa_arena_alloc(&state->arena, size);
+    state->block_start = sa_arena_alloc(&state->arena, size);
+    state->block_length = sa_arena_alloc(&state->arena, size);
+    state->decoded = 0;
+}
+
+static inline int machine_predecessor(const SearchState *state, int operation) {
+    int index = state->position[operation];
+    return index > machine_start[machine_of(operation)] ? state->order[index - 1] : -1;
+}
+
+static inline int machine_successor(const SearchState *state, int operation) {
+    int index = state->position[operation];
+    return index + 1 < machine_start[machine_of(operation) + 1] ? state->order[index + 1] : -1;
+}
+
+void index_positions(SearchState *state, int first, int last) {
+    for (int i = first; i <= last; ++i) {
+        state->position[state->order[i]] = i;
+    }
+}
+
+// Random solution: repeatedly pick a job with operations left and append its
+// next operation to its machine, so the disjunctive graph has no cycle
+void generate_initial_solution(SearchState *state, sa_rng *rng) {
+    int next[num_jobs], unfinished[num_jobs], fill[num_machines];
+    for (int i = 0; i < num_jobs; ++i) {
+        next[i] = i * num_machines;
+        unfinished[i] = i;
+    }
+    for (int k = 0; k < num_machines; ++k) {
+        fill[k] = machine_start[k];
+    }
+    int remaining = num_jobs;
+    while (remaining > 0) {
+        int pick = sa_rng_below(rng, remaining);
+        int job = unfinished[pick];
+        int operation = next[job]++;
+        state->order[fill[machine_of(operation)]++] = operation;
+        if (next[job] == (job + 1) * num_machines) {
+            unfinished[pick] = unfinished[--remaining];
         }
     }
+    index_positions(state, 0, num_operations - 1);
+    state->decoded = 0;
 }
 
-int calculate_makespan(int solution[]) {
-    int completion_times[MAX_JOBS][MAX_MACHINES] = {0};
-    int makespan = 0;
+void move_operation(SearchState *state, int from, int to) {
+    int operation = state->order[from];
+    if (from < to) {
+        memmove(&state->order[from], &state->order[from + 1], (to - from) * sizeof(int));
+    } else {
+        memmove(&state->order[to + 1], &state->order[to], (from - to) * sizeof(int));
+    }
+    state->order[to] = operation;
+    index_positions(state, from < to ? from : to, from < to ? to : from);
+}
 
-    for (int i = 0; i < num_jobs; ++i) {
-        for (int j = 0; j < num_machines; ++j) {
-            int machine = solution[i * num_machines + j];
-            int processing_time = processing_times[i][machine];
-            int setup_time = (j == 0) ? 0 : setup_times[solution[i * num_machines + (j - 1)]][machine];
-            completion_times[i][machine] = (j == 0) ? processing_time : completion_times[i][solution[i * num_machines + (j - 1)]] + setup_time + processing_time;
+// Earliest start of an operation once its predecessors are scheduled
+static inline int release(const SearchState *state, int operation) {
+    int job = job_predecessor(operation), machine = machine_predecessor(state, operation);
+    int start = job >= 0 ? state->heads[job] + duration(job) : 0;
+    if (machine >= 0 && state->heads[machine] + duration(machine) + setup(machine, operation) > start) {
+        start = state->heads[machine] + duration(machine) + setup(machine, operation);
+    }
+    return start;
+}
 
-            if (completion_times[i][machine] > makespan) {
-                makespan = completion_times[i][machine];
+// Reschedule the operations ranked first and later in the topological order
+// (Kahn's algorithm on that part of the graph) and rank them again. The
+// operations ranked before first keep their heads: a move on a machine only
+// changes the predecessors of its segment and of the operation after it,
+// all ranked after the first operation of the segment. Returns -1 when the
+// sequences contain a cycle.
+int propagate_heads(SearchState *state, int first) {
+    int queued = first;
+    for (int r = first; r < num_operations; ++r) {
+        int o = state->topological[r];
+        int job = job_predecessor(o), machine = machine_predecessor(state, o);
+        state->pending[o] = (job >= 0 && state->rank[job] >= first) +
+                            (machine >= 0 && state->rank[machine] >= first);
+    }
+    // Ready operations are gathered in trial_heads, used here as a queue
+    int *ready = state->trial_heads;
+    for (int r = first; r < num_operations; ++r) {
+        int o = state->topological[r];
+        if (state->pending[o] == 0) {
+            ready[queued++] = o;
+        }
+    }
+    for (int scheduled = first; scheduled < queued; ++scheduled) {
+        int o = ready[scheduled];
+        state->heads[o] = release(state, o);
+        int successors[2] = {job_successor(o), machine_successor(state, o)};
+        for (int s = 0; s < 2; ++s) {
+            if (successors[s] >= 0 && --state->pending[successors[s]] == 0) {
+                ready[queued++] = successors[s];
             }
         }
     }
+    if (queued < num_operations) {
+        return -1;
+    }
+    for (int r = first; r < num_operations; ++r) {
+        state->topological[r] = ready[r];
+        state->rank[ready[r]] = r;
+    }
+    return 0;
+}
 
-    return makespan;
+// Recompute the tails of the operations ranked last and earlier, the
+// makespan and one critical path split into blocks
+void refresh_tails(SearchState *state, int last) {
+    for (int r = last; r >= 0; --r) {
+        int o = state->topological[r];
+        int job = job_successor(o), machine = machine_successor(state, o);
+        int tail = job >= 0 ? duration(job) + state->tails[job] : 0;
+        if (machine >= 0 && setup(o, machine) + duration(machine) + state->tails[machine] > tail) {
+            tail = setup(o, machine) + duration(machine) + state->tails[machine];
+        }
+        state->tails[o] = tail;
+    }
+    int end = 0;
+    state->makespan = 0;
+    for (int o = 0; o < num_operations; ++o) {
+        if (state->heads[o] + duration(o) > state->makespan) {
+            state->makespan = state->heads[o] + duration(o);
+            end = o;
+        }
+    }
+    // Walk back through the predecessors that determine each head,
+    // preferring the machine arc
+    int length = 0;
+    for (int o = end; o >= 0;) {
+        state->path[length++] = o;
+        int machine = machine_predecessor(state, o), job = job_predecessor(o);
+        if (machine >= 0 && state->heads[machine] + duration(machine) + setup(machine, o) == state->heads[o]) {
+            o = machine;
+        } else if (job >= 0 && state->heads[job] + duration(job) == state->heads[o]) {
+            o = job;
+        } else {
+            o = -1;
+        }
+    }
+    for (int i = 0; i < length / 2; ++i) {
+        int temp = state->path[i];
+        state->path[i] = state->path[length - 1 - i];
+        state->path[length - 1 - i] = temp;
+    }
+    state->blocks = 0;
+    for (int i = 0; i < length;) {
+        int j = i + 1;
+        while (j < length && machine_successor(state, state->path[j - 1]) == state->path[j]) {
+            ++j;
+        }
+        if (j - i >= 2) {
+            state->block_start[state->blocks] = i;
+            state->block_length[state->blocks] = j - i;
+            state->blocks++;
+        }
+        i = j;
+    }
+    state->decoded = 1;
 }
 
-void copy_solution(int dest[], int src[]) {
-    for (int i = 0; i < num_jobs * num_machines; ++i) {
-        dest[i] = src[i];
+// Decode the whole solution: rank every operation machine by machine (a
+// valid start for propagate_heads, which then finds the real order)
+void decode(SearchState *state) {
+    for (int o = 0; o < num_operations; ++o) {
+        state->topological[o] = o;
+        state->rank[o] = o;
     }
+    propagate_heads(state, 0);
+    refresh_tails(state, num_operations - 1);
 }
 
-double acceptance_probability(int current_cost, int new_cost, double temperature) {
-    if (new_cost < current_cost) {
-        return 1.0;
+// Makespan of the current solution. After an accepted move apply_move has
+// already brought the graph up to date; otherwise it is decoded in full
+// (whatever the limit, so that the graph kept for proposing moves is complete).
+double solution_cost(void *data, double limit) {
+    SearchState *state = data;
+    (void)limit;
+    if (!state->decoded) {
+        decode(state);
     }
-    return exp((current_cost - new_cost) / temperature);
+    return state->makespan;
 }
 
-void simulated_annealing(int current_solution[], int best_solution[]) {
-    double temperature = 1000.0;
-    double cooling_rate = 0.99;
-    int current_cost = calculate_makespan(current_solution);
-    int best_cost = current_cost;
-    int iteration = 0;
+// Draws of a critical-block move before a step is given up
+#define PROPOSAL_TRIES 8
 
-    while (temperature > 1.0) {
-        int neighbor_solution[MAX_JOBS * MAX_MACHINES];
-        copy_solution(neighbor_solution, current_solution);
+// Draw a move on a critical block: an operation moves right after the last
+// operation of its block or right before the first, or only swaps with its
+// neighbour in the block when the heads cannot rule out a cycle. With setups
+// even such a swap can close a cycle, so a move that fails both tests is
+// dropped. Moving u after the block's end v is safe when the job successor
+// of u starts after v does: any path from it to the block would start later.
+// Moving v before the block's start u is safe when the job predecessor of v
+// starts before u ends. Returns 0 for a dropped move.
+static int draw_move(const SearchState *state, sa_rng *rng, Move *move) {
+    int block = sa_rng_below(rng, state->blocks);
+    const int *operations = &state->path[state->block_start[block]];
+    int length = state->block_length[block];
+    int pick = sa_rng_below(rng, 2 * (length - 1));
+    if (pick < length - 1) {
+        int u = operations[pick], next = job_successor(u);
+        for (int target = length - 1; target > pick; target = pick + 1) {
+            int v = operations[target];
+            if (next < 0 || state->heads[next] + duration(next) > state->heads[v]) {
+                move->from = state->position[u];
+                move->to = state->position[v];
+                return 1;
+            }
+            if (target == pick + 1) {
+                return 0;
+            }
+        }
+    } else {
+        pick = pick - (length - 1) + 1;
+        int v = operations[pick], previous = job_predecessor(v);
+        for (int target = 0; target < pick; target = pick - 1) {
+            int u = operations[target];
+            if (previous < 0 || state->heads[previous] < state->heads[u] + duration(u)) {
+                move->from = state->position[v];
+                move->to = state->position[u];
+                return 1;
+            }
+            if (target == pick - 1) {
+                return 0;
+            }
+        }
+    }
+    return 0;
+}
 
-        // Generate a neighboring solution (swap two random positions)
-        int pos1 = rand() % (num_jobs * num_machines);
-        int pos2 = rand() % (num_jobs * num_machines);
-        int temp = neighbor_solution[pos1];
-        neighbor_solution[pos1] = neighbor_solution[pos2];
-        neighbor_solution[pos2] = temp;
+// Pick a move on a critical block, drawing again after a dropped one. There
+// is no move without a block, or when every draw is dropped: without a block
+// every critical arc is a job arc, and the makespan is a job's length.
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    if (state->blocks == 0) {
+        return 0;
+    }
+    for (int tries = 0; tries < PROPOSAL_TRIES; tries++) {
+        if (draw_move(state, rng, move_data)) {
+            return 1;
+        }
+    }
+    return 0;
+}
 
-        int neighbor_cost = calculate_makespan(neighbor_solution);
+// Operation at position index of order once the move is made, for index
+// between from and to
+static inline int moved_operation(const SearchState *state, const Move *move, int index) {
+    if (move->from < move->to) {
+        return index < move->to ? state->order[index + 1] : state->order[move->from];
+    }
+    return index > move->to ? state->order[index - 1] : state->order[move->from];
+}
 
-        // Decide if we should accept the neighbor
-        if (acceptance_probability(current_cost, neighbor_cost, temperature) > ((double)rand() / RAND_MAX)) {
-            copy_solution(current_solution, neighbor_solution);
-            current_cost = neighbor_cost;
+// Estimate the makespan after a move from the heads and tails of the
+// operations it shifts, with the setups of their new neighbours: new heads
+// run forward from the machine predecessor of the segment, new tails back
+// from its machine successor, and the estimate is the longest path through
+// the segment. The exact makespan is only computed for accepted moves.
+double move_cost(void *data, const void *move_data, double limit) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    (void)limit;
+    if (move->from == move->to) {
+        return state->makespan;
+    }
+    int first = move->from < move->to ? move->from : move->to;
+    int last = move->from < move->to ? move->to : move->from;
+    int machine = machine_of(state->order[first]);
+    int previous = first > machine_start[machine] ? state->order[first - 1] : -1;
+    for (int i = first; i <= last; ++i) {
+        int o = moved_operation(state, move, i);
+        int ready = 0;
+        if (previous >= 0) {
+            int head = i == first ? state->heads[previous] : state->trial_heads[previous];
+            ready = head + duration(previous) + setup(previous, o);
+        }
+        int job = job_predecessor(o);
+        if (job >= 0 && state->heads[job] + duration(job) > ready) {
+            ready = state->heads[job] + duration(job);
+        }
+        state->trial_heads[o] = ready;
+        previous = o;
+    }
+    int next = last + 1 < machine_start[machine + 1] ? state->order[last + 1] : -1;
+    int estimate = 0;
+    for (int i = last; i >= first; --i) {
+        int o = moved_operation(state, move, i);
+        int following = 0;
+        if (next >= 0) {
+            int tail = i == last ? state->tails[next] : state->trial_tails[next];
+            following = setup(o, next) + duration(next) + tail;
+        }
+        int job = job_successor(o);
+        if (job >= 0 && duration(job) + state->tails[job] > following) {
+            following = duration(job) + state->tails[job];
+        }
+        state->trial_tails[o] = following;
+        if (state->trial_heads[o] + duration(o) + following > estimate) {
+            estimate = state->trial_heads[o] + duration(o) + following;
         }
+        next = o;
+    }
+    return estimate;
+}
 
-        // Update the best solution found so far
-        if (current_cost < best_cost) {
-            best_cost = current_cost;
-            copy_solution(best_solution, current_solution);
+// Apply an accepted move and bring the graph up to date: heads from the
+// first operation of the segment in topological order on, tails up to the
+// last operation of the segment
+void apply_move(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    if (move->from == move->to) {
+        return;
+    }
+    int first = move->from < move->to ? move->from : move->to;
+    int last = move->from < move->to ? move->to : move->from;
+    int earliest = state->rank[state->order[first]];
+    move_operation(state, move->from, move->to);
+    if (propagate_heads(state, earliest) != 0) {
+        decode(state); // Unreachable: proposals never close a cycle
+        return;
+    }
+    int latest = 0;
+    for (int i = first; i <= last; ++i) {
+        if (state->rank[state->order[i]] > latest) {
+            latest = state->rank[state->order[i]];
         }
+    }
+    refresh_tails(state, latest);
+}
 
-        // Cool the temperature
-        temperature *= cooling_rate;
-        iteration++;
+void save_best_solution(void *data) {
+    SearchState *state = data;
+    memcpy(state->best_order, state->order, num_operations * sizeof(int));
+}
+
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    memcpy(to->order, from->order, num_operations * sizeof(int));
+    memcpy(to->best_order, from->best_order, num_operations * sizeof(int));
+    index_positions(to, 0, num_operations - 1);
+    to->decoded = 0;
+}
+
+void *clone_state(const void *data) {
+    SearchState *clone = malloc(sizeof(SearchState));
+    allocate_state(clone);
+    copy_state(clone, data);
+    return clone;
+}
+
+void destroy_state(void *data) {
+    SearchState *state = data;
+    sa_arena_free(&state->arena);
+    free(state);
+}
+
+void restart_solution(void *data, sa_rng *rng) {
+    generate_initial_solution(data, rng);
+}
+
+void simulated_annealing(const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    allocate_state(&state);
+    generate_initial_solution(&state, rng);
+    sa_params params = {
+        .initial_temperature = 1000.0,
+        .cooling_rate = 0.99,
+        .min_temperature = 1.0,
+        .iterations_per_temperature = 100,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .estimated = 1,
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_solution,
+        .cost = solution_cost,
+        .propose = propose_move,
+        .evaluate = move_cost,
+        .apply = apply_move,
+        .save_best = save_best_solution,
+    };
+    int best_makespan = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
+
+    // Decode the best solution to print its machine and start times
+    memcpy(state.order, state.best_order, num_operations * sizeof(int));
+    index_positions(&state, 0, num_operations - 1);
+    decode(&state);
+    printf("Best Solution (machine, start):\n");
+    for (int i = 0; i < num_jobs; ++i) {
+        printf("Job %d: ", i + 1);
+        for (int j = 0; j < num_machines; ++j) {
+            int o = i * num_machines + j;
+            printf("(%d,%d) ", machine_of(o) + 1, state.heads[o]);
+        }
+        printf("\n");
     }
+    printf("Best Makespan: %d\n", best_makespan);
+    sa_arena_free(&state.arena);
 }
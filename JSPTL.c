@@ -1,179 +1,782 @@
 // Job-Shop Scheduling Problem with Time Lags (JSPTL)
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <math.h>
 #include <time.h>
-#define MAX_JOBS 10      // Maximum number of jobs
-#define MAX_MACHINES 10  // Maximum number of machines
-#define MAX_OPERATIONS 10  // Maximum number of operations per job
-#define MAX_ITER 10000   // Maximum iterations for simulated annealing
-#define INITIAL_TEMP 100.0  // Initial temperature
-#define COOLING_RATE 0.95   // Cooling rate for simulated annealing
-
-// Structure for an operation
+#include "sa.h"
+#include "sa_instance.h"
+#include "sa_arena.h"
+#define EXAMPLE_JOBS 5       // Jobs in the built-in example
+#define EXAMPLE_MACHINES 3   // Machines (and operations per job) in the example
+#define INITIAL_TEMP 100.0   // Initial temperature
+#define COOLING_RATE 0.95    // Cooling rate for simulated annealing
+
+// Problem instance. Operation j of job i is operation i * num_machines + j;
+// it runs on instance.shop.machine[o] for instance.shop.time[o] and the next
+// operation of the job starts between instance.min_lag[o] and
+// instance.max_lag[o] (unbounded when -1) after it ends.
+sa_timelag_jobshop instance;
+int num_jobs;
+int num_machines;
+int num_operations;
+// A solution lists the operations of each machine in processing order:
+// machine k runs order[k * num_jobs .. (k + 1) * num_jobs - 1]
+int *machine_start;
+
+// Function prototypes
+void build_example(sa_rng *rng);
+int index_machines();
+void simulated_annealing(const sa_options *options, sa_rng *rng);
+
+// Main function
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
+    if (options.instance != NULL) {
+        if (sa_load_timelag_jobshop(options.instance, options.format, options.index, &instance) != 0) {
+            return 1;
+        }
+    } else {
+        build_example(&rng);
+    }
+    if (index_machines() != 0) {
+        fprintf(stderr, "JSPTL needs every job to visit every machine once\n");
+        return 1;
+    }
+
+    // Apply simulated annealing to solve the JSPTL problem
+    simulated_annealing(&options, &rng);
+
+    free(machine_start);
+    sa_free_timelag_jobshop(&instance);
+    return 0;
+}
+
+// Example: every job visits machines 0, 1, 2 in turn with random times
+// (1 to 10), waits 0 to 2 between operations and at most 5 more than that
+void build_example(sa_rng *rng) {
+    int n = EXAMPLE_JOBS, m = EXAMPLE_MACHINES;
+    instance.shop.jobs = n;
+    instance.shop.machines = m;
+    instance.shop.machine = malloc(n * m * sizeof(int));
+    instance.shop.time = malloc(n * m * sizeof(int));
+    instance.min_lag = malloc(n * m * sizeof(int));
+    instance.max_lag = malloc(n * m * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < m; j++) {
+            int o = i * m + j;
+            instance.shop.machine[o] = j % m;
+            instance.shop.time[o] = sa_rng_below(rng, 10) + 1;
+            instance.min_lag[o] = j < m - 1 ? sa_rng_below(rng, 3) : 0;
+            instance.max_lag[o] = j < m - 1 ? instance.min_lag[o] + sa_rng_below(rng, 6) : -1;
+        }
+    }
+}
+
+// Check that each job visits each machine once and lay out the machine sequences
+int index_machines() {
+    num_jobs = instance.shop.jobs;
+    num_machines = instance.shop.machines;
+    num_operations = num_jobs * num_machines;
+    for (int i = 0; i < num_jobs; i++) {
+        int seen[num_machines];
+        memset(seen, 0, sizeof(seen));
+        for (int j = 0; j < num_machines; j++) {
+            if (seen[instance.shop.machine[i * num_machines + j]]++) {
+                return -1;
+            }
+        }
+    }
+    machine_start = malloc((num_machines + 1) * sizeof(int));
+    for (int k = 0; k <= num_machines; k++) {
+        machine_start[k] = k * num_jobs;
+    }
+    return 0;
+}
+
+static inline int duration(int operation) {
+    return instance.shop.time[operation];
+}
+
+static inline int machine_of(int operation) {
+    return instance.shop.machine[operation];
+}
+
+static inline int job_predecessor(int operation) {
+    return operation % num_machines > 0 ? operation - 1 : -1;
+}
+
+static inline int job_successor(int operation) {
+    return (operation + 1) % num_machines > 0 ? operation + 1 : -1;
+}
+
+// Move: take the operation at position from in order out and reinsert it at
+// position to, on the same machine (from == to changes nothing)
 typedef struct {
-    int machine;   // Machine index
-    int processing_time;  // Processing time
-} Operation;
+    int from;
+    int to;
+} Move;
 
-// Structure for a job
+// Annealing state, carved from one arena per chain: the machine sequences
+// (order, with the position of every operation in it), the best sequences
+// seen and the earliest start (head) of every operation. The heads are the
+// longest paths in the temporal network of the solution: an arc from a job's
+// operation to its next one of weight duration + minimum lag, one back of
+// weight -(duration + maximum lag), and one from each operation to its
+// machine successor of weight duration. The solution is feasible when the
+// network has no positive cycle. Of the longest paths to an operation, the
+// one with the fewest arcs is taken and depth[o] is that number: an arc is
+// tight when it lies on such a path (head and depth both match), so tight
+// arcs never close a cycle, even where a minimum lag equals the maximum.
+// One critical path is kept, split into blocks of two or more consecutive
+// operations on the same machine.
 typedef struct {
-    int num_operations;   // Number of operations for this job
-    Operation operations[MAX_OPERATIONS];  // Operations of the job
-} Job;
-
-// Function to calculate the total completion time (makespan) of a schedule
-int calculate_makespan(Job jobs[], int n_jobs) {
-    int machine_end_times[MAX_MACHINES] = {0};  // End times of machines
-    int job_end_times[MAX_JOBS][MAX_OPERATIONS] = {{0}};  // End times of jobs' operations
-    int total_makespan = 0;
-
-    // Calculate completion times for each job's operations
-    for (int i = 0; i < n_jobs; i++) {
-        int job_makespan = 0;
-        for (int j = 0; j < jobs[i].num_operations; j++) {
-            int machine = jobs[i].operations[j].machine;
-            int processing_time = jobs[i].operations[j].processing_time;
-
-            // Calculate start time of operation j of job i
-            int start_time = machine_end_times[machine];
-
-            // Account for time lags if applicable
-            if (j > 0) {
-                start_time = fmax(start_time, job_end_times[i][j-1]);
-            }
+    sa_arena arena;
+    int *order;
+    int *position;
+    int *best_order;
+    int *heads;
+    int *depth;
+    int *path;           // Critical path, from the first operation to the last
+    int *block_start;    // Index in path of the first operation of each block
+    int *block_length;
+    int blocks;
+    int makespan;
+    int *topological;    // The operations in an order the job and machine arcs allow
+    int *rank;           // Place of each operation in topological
+    // Scratch for propagating a move, kept until apply_move in case the
+    // move evaluated last is the one accepted
+    int *trial_heads;    // Heads and depths of the touched operations
+    int *trial_depth;
+    int *trial_topological; // New order of the ranks low to high
+    int *trial_rank;
+    int *touched;        // Operations whose heads the propagation reset or raised
+    int *mark;           // mark[o] == stamp when o is touched
+    int *affected;       // affected[o] == stamp when o lost every tight arc into it
+    int *arcs;           // Arcs on the path found to each touched operation
+    int *pending;        // Unordered predecessors of each operation (reordering scratch)
+    int *heap;           // Operations waiting in the heap, by key
+    int *key;
+    int *waiting;        // waiting[o] is 1 while o is in the heap
+    int touches;
+    int heap_size;
+    int low;             // Ranks reordered by the move
+    int high;
+    int stamp;
+    int trial_valid;     // The trial fields describe the solution after trial_move
+    Move trial_move;
+    int trial_makespan;
+} SearchState;
 
-            // Calculate end time of operation j of job i
-            int end_time = start_time + processing_time;
+void allocate_state(SearchState *state) {
+    size_t size = num_operations * sizeof(int);
+    sa_arena_init(&state->arena, 22 * sa_arena_size(size));
+    state->order = sa_arena_alloc(&state->arena, size);
+    state->position = sa_arena_alloc(&state->arena, size);
+    state->best_order = sa_arena_alloc(&state->arena, size);
+    state->heads = sa_arena_alloc(&state->arena, size);
+    state->depth = sa_arena_alloc(&state->arena, size);
+    state->path = sa_arena_alloc(&state->arena, size);
+    state->block_start = sa_arena_alloc(&state->arena, size);
+    state->block_length = sa_arena_alloc(&state->arena, size);
+    state->topological = sa_arena_alloc(&state->arena, size);
+    state->rank = sa_arena_alloc(&state->arena, size);
+    state->trial_heads = sa_arena_alloc(&state->arena, size);
+    state->trial_depth = sa_arena_alloc(&state->arena, size);
+    state->trial_topological = sa_arena_alloc(&state->arena, size);
+    state->trial_rank = sa_arena_alloc(&state->arena, size);
+    state->touched = sa_arena_alloc(&state->arena, size);
+    state->mark = sa_arena_alloc(&state->arena, size);
+    state->affected = sa_arena_alloc(&state->arena, size);
+    state->arcs = sa_arena_alloc(&state->arena, size);
+    state->pending = sa_arena_alloc(&state->arena, size);
+    state->heap = sa_arena_alloc(&state->arena, size);
+    state->key = sa_arena_alloc(&state->arena, size);
+    state->waiting = sa_arena_alloc(&state->arena, size);
+    for (int o = 0; o < num_operations; o++) {
+        state->topological[o] = o;
+        state->rank[o] = o;
+    }
+    memset(state->mark, 0, size);
+    memset(state->affected, 0, size);
+    memset(state->waiting, 0, size);
+    state->heap_size = 0;
+    state->stamp = 0;
+    state->trial_valid = 0;
+}
 
-            // Update job's operation end time
-            job_end_times[i][j] = end_time;
+static inline int machine_predecessor(const SearchState *state, int operation) {
+    int index = state->position[operation];
+    return index > machine_start[machine_of(operation)] ? state->order[index - 1] : -1;
+}
 
-            // Update machine's end time
-            machine_end_times[machine] = end_time;
+static inline int machine_successor(const SearchState *state, int operation) {
+    int index = state->position[operation];
+    return index + 1 < machine_start[machine_of(operation) + 1] ? state->order[index + 1] : -1;
+}
+
+void index_positions(SearchState *state, int first, int last) {
+    for (int i = first; i <= last; i++) {
+        state->position[state->order[i]] = i;
+    }
+}
+
+void move_operation(SearchState *state, int from, int to) {
+    int operation = state->order[from];
+    if (from < to) {
+        memmove(&state->order[from], &state->order[from + 1], (to - from) * sizeof(int));
+    } else {
+        memmove(&state->order[to + 1], &state->order[to], (from - to) * sizeof(int));
+    }
+    state->order[to] = operation;
+    index_positions(state, from < to ? from : to, from < to ? to : from);
+}
 
-            // Update job's total makespan
-            job_makespan = fmax(job_makespan, end_time);
+// Random solution: the jobs in random order, each one before the next on
+// every machine. Every arc between two jobs then runs forward in that
+// order, so a cycle stays within one job and the solution is feasible.
+void generate_initial_solution(SearchState *state, sa_rng *rng) {
+    int jobs[num_jobs];
+    for (int i = 0; i < num_jobs; i++) {
+        jobs[i] = i;
+    }
+    for (int i = num_jobs - 1; i > 0; i--) {
+        int k = sa_rng_below(rng, i + 1);
+        int temp = jobs[i];
+        jobs[i] = jobs[k];
+        jobs[k] = temp;
+    }
+    int fill[num_machines];
+    for (int k = 0; k < num_machines; k++) {
+        fill[k] = machine_start[k];
+    }
+    for (int i = 0; i < num_jobs; i++) {
+        for (int j = 0; j < num_machines; j++) {
+            int operation = jobs[i] * num_machines + j;
+            state->order[fill[machine_of(operation)]++] = operation;
         }
-        // Update total makespan
-        total_makespan += job_makespan;
     }
+    index_positions(state, 0, num_operations - 1);
+    state->trial_valid = 0;
+}
+
+// Arcs entering an operation in the temporal network; returns their number
+static inline int in_arcs(const SearchState *state, int operation, int sources[3], int weights[3]) {
+    int n = 0;
+    int machine = machine_predecessor(state, operation), job = job_predecessor(operation);
+    int next = job_successor(operation);
+    if (machine >= 0) {
+        sources[n] = machine;
+        weights[n++] = duration(machine);
+    }
+    if (job >= 0) {
+        sources[n] = job;
+        weights[n++] = duration(job) + instance.min_lag[job];
+    }
+    if (next >= 0 && instance.max_lag[operation] >= 0) {
+        sources[n] = next;
+        weights[n++] = -duration(operation) - instance.max_lag[operation];
+    }
+    return n;
+}
+
+// Arcs leaving an operation in the temporal network; returns their number
+static inline int out_arcs(const SearchState *state, int operation, int targets[3], int weights[3]) {
+    int n = 0;
+    int job = job_successor(operation), machine = machine_successor(state, operation);
+    int back = job_predecessor(operation);
+    if (job >= 0) {
+        targets[n] = job;
+        weights[n++] = duration(operation) + instance.min_lag[operation];
+    }
+    if (machine >= 0) {
+        targets[n] = machine;
+        weights[n++] = duration(operation);
+    }
+    if (back >= 0 && instance.max_lag[back] >= 0) {
+        targets[n] = back;
+        weights[n++] = -duration(back) - instance.max_lag[back];
+    }
+    return n;
+}
+
+// Head and depth of an operation during a propagation: its trial values once touched
+static inline int trial_head(const SearchState *state, int operation) {
+    return state->mark[operation] == state->stamp ? state->trial_heads[operation] : state->heads[operation];
+}
+
+static inline int trial_depth(const SearchState *state, int operation) {
+    return state->mark[operation] == state->stamp ? state->trial_depth[operation] : state->depth[operation];
+}
+
+// Rank of an operation in the solution being propagated
+static inline int trial_rank(const SearchState *state, int operation) {
+    int rank = state->rank[operation];
+    return rank >= state->low && rank <= state->high ? state->trial_rank[operation] : rank;
+}
+
+static inline void touch(SearchState *state, int operation) {
+    state->mark[operation] = state->stamp;
+    state->touched[state->touches++] = operation;
+}
+
+// Binary heap of operations, lowest key first
+static void heap_push(SearchState *state, int operation, int key) {
+    int *heap = state->heap;
+    int i = state->heap_size++;
+    while (i > 0 && state->key[heap[(i - 1) / 2]] > key) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = operation;
+    state->key[operation] = key;
+    state->waiting[operation] = 1;
+}
+
+static int heap_pop(SearchState *state) {
+    int *heap = state->heap, top = heap[0];
+    int last = heap[--state->heap_size], key = state->key[last];
+    int i = 0;
+    for (int child = 1; child < state->heap_size; child = 2 * i + 1) {
+        if (child + 1 < state->heap_size && state->key[heap[child + 1]] < state->key[heap[child]]) {
+            child++;
+        }
+        if (state->key[heap[child]] >= key) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    state->waiting[top] = 0;
+    return top;
+}
 
-    return total_makespan;
+// Empty the heap after a propagation stopped early
+static void heap_clear(SearchState *state) {
+    while (state->heap_size > 0) {
+        state->waiting[state->heap[--state->heap_size]] = 0;
+    }
 }
 
-// Function to generate a random initial solution
-void generate_initial_solution(Job jobs[], int n_jobs) {
-    // Example initialization (you can modify this based on your needs)
-    for (int i = 0; i < n_jobs; i++) {
-        jobs[i].num_operations = 2;  // Example: each job has 2 operations
-        for (int j = 0; j < jobs[i].num_operations; j++) {
-            jobs[i].operations[j].machine = j % 3;  // Example: alternate machines M0, M1, M2
-            jobs[i].operations[j].processing_time = rand() % 10 + 1;  // Random processing time (1 to 10)
+// Order the operations ranked low to high again for the machine sequences
+// as they are now (Kahn's algorithm on the job and machine arcs between
+// them), into trial_topological and trial_rank. A move on one machine only
+// changes arcs between its segment, the operation before it and the one
+// after it, so taking low and high as the ranks of the first and last
+// operation of the segment keeps every other rank valid. Returns -1 when
+// the sequences close a cycle.
+int reorder_ranks(SearchState *state, int low, int high) {
+    state->low = low;
+    state->high = high;
+    int queued = low;
+    for (int r = low; r <= high; r++) {
+        int o = state->topological[r];
+        int job = job_predecessor(o), machine = machine_predecessor(state, o);
+        state->pending[o] = (job >= 0 && state->rank[job] >= low && state->rank[job] <= high) +
+                            (machine >= 0 && state->rank[machine] >= low && state->rank[machine] <= high);
+        if (state->pending[o] == 0) {
+            state->trial_topological[queued++] = o;
         }
     }
+    for (int r = low; r < queued; r++) {
+        int o = state->trial_topological[r];
+        state->trial_rank[o] = r;
+        int successors[2] = {job_successor(o), machine_successor(state, o)};
+        for (int s = 0; s < 2; s++) {
+            int next = successors[s];
+            if (next >= 0 && state->rank[next] >= low && state->rank[next] <= high && --state->pending[next] == 0) {
+                state->trial_topological[queued++] = next;
+            }
+        }
+    }
+    return queued == high + 1 ? 0 : -1;
 }
 
-// Function to generate a neighbor solution (swap two operations)
-void generate_neighbor_solution(Job jobs[], int n_jobs) {
-    // Randomly select a job and two different operations within that job
-    int job_idx = rand() % n_jobs;
-    if (jobs[job_idx].num_operations < 2) return;  // Job should have at least two operations
+// Whether a path of the given head and depth beats the operation's own:
+// a longer one, or one as long with fewer arcs
+static inline int improves(const SearchState *state, int operation, int head, int depth) {
+    int current = trial_head(state, operation);
+    return head > current || (head == current && depth < trial_depth(state, operation));
+}
 
-    int op1_idx = rand() % jobs[job_idx].num_operations;
-    int op2_idx = rand() % jobs[job_idx].num_operations;
-    while (op2_idx == op1_idx) {
-        op2_idx = rand() % jobs[job_idx].num_operations;
+// Mark the operations whose head or depth may fall after a change of the
+// arcs into the listed seeds, in order of depth: an operation is affected
+// when no arc into it is still tight from an operation that is not. Tight
+// arcs out of an affected operation make their heads candidates in turn;
+// every other head keeps a path it had, as long as before.
+static void find_affected(SearchState *state, const int *seeds, int count) {
+    int sources[3], weights[3];
+    for (int s = 0; s < count; s++) {
+        heap_push(state, seeds[s], state->depth[seeds[s]]);
+    }
+    while (state->heap_size > 0) {
+        int o = heap_pop(state);
+        int n = in_arcs(state, o, sources, weights), supported = state->depth[o] == 0;
+        for (int a = 0; a < n && !supported; a++) {
+            int p = sources[a];
+            supported = state->affected[p] != state->stamp && state->heads[p] + weights[a] == state->heads[o] &&
+                        state->depth[p] + 1 == state->depth[o];
+        }
+        if (supported) {
+            continue;
+        }
+        state->affected[o] = state->stamp;
+        touch(state, o);
+        int targets[3];
+        n = out_arcs(state, o, targets, weights);
+        for (int a = 0; a < n; a++) {
+            int v = targets[a];
+            if (state->affected[v] != state->stamp && !state->waiting[v] &&
+                state->heads[o] + weights[a] == state->heads[v] && state->depth[o] + 1 == state->depth[v]) {
+                heap_push(state, v, state->depth[v]);
+            }
+        }
     }
+}
 
-    // Swap the machines of the selected operations
-    int temp_machine = jobs[job_idx].operations[op1_idx].machine;
-    jobs[job_idx].operations[op1_idx].machine = jobs[job_idx].operations[op2_idx].machine;
-    jobs[job_idx].operations[op2_idx].machine = temp_machine;
+// Raise the head of operation to head over a path of depth arcs, reached
+// from parent. Returns 1 when that shows a positive cycle: arcs[o] counts
+// the arcs on the path found to o through touched operations, and a path
+// longer than the touched operations are many passes one of them twice,
+// around a cycle whose every pass raised it.
+static inline int raise_head(SearchState *state, int operation, int parent, int head, int depth) {
+    if (state->mark[operation] != state->stamp) {
+        touch(state, operation);
+    }
+    state->trial_heads[operation] = head;
+    state->trial_depth[operation] = depth;
+    state->arcs[operation] = state->arcs[parent] + 1;
+    return state->arcs[operation] > state->touches;
 }
 
-// Simulated annealing algorithm
-void simulated_annealing(Job jobs[], int n_jobs) {
-    Job current_solution[MAX_JOBS];
-    Job best_solution[MAX_JOBS];
-
-    // Initialize current solution
-    generate_initial_solution(current_solution, n_jobs);
-    // Initialize best solution found so far
-    // Copy current solution to best solution
-    for (int i = 0; i < n_jobs; i++) {
-        best_solution[i] = current_solution[i];
-    }
-
-    double temperature = INITIAL_TEMP;
-    int iter = 0;
-
-    while (temperature > 0.1 && iter < MAX_ITER) {
-        // Generate a neighbor solution
-        generate_neighbor_solution(current_solution, n_jobs);
-
-        // Calculate makespan for current and neighbor solutions
-        int current_makespan = calculate_makespan(current_solution, n_jobs);
-        int best_makespan = calculate_makespan(best_solution, n_jobs);
-
-        // Decide whether to accept the neighbor solution
-        if (current_makespan < best_makespan) {
-            // Accept the neighbor solution
-            // Update best solution
-            for (int i = 0; i < n_jobs; i++) {
-                best_solution[i] = current_solution[i];
+// Longest paths after a change of the arcs into the operations listed in
+// seeds, once reorder_ranks has ordered the solution. The affected
+// operations are reset from the arcs entering them from the others, which
+// leaves every head a lower bound of its new value; heads then rise by
+// label correcting, relaxing the operations lowest rank first so that each
+// is normally relaxed once, after all of its job and machine predecessors.
+// Only a maximum lag that raises an earlier operation sends the
+// propagation back. New heads and depths go to trial_heads and trial_depth
+// for the touched operations only. As heads only grow, the propagation
+// stops once an operation ends after limit. Returns the makespan, INFINITY
+// for an infeasible solution, or a value above limit.
+double propagate(SearchState *state, const int *seeds, int count, double limit) {
+    int sources[3], weights[3];
+    state->trial_valid = 0;
+    if (++state->stamp == 0) {
+        memset(state->mark, 0, num_operations * sizeof(int));
+        memset(state->affected, 0, num_operations * sizeof(int));
+        state->stamp = 1;
+    }
+    state->touches = 0;
+    find_affected(state, seeds, count);
+
+    int *heads = state->trial_heads, *depth = state->trial_depth;
+    for (int t = 0; t < state->touches; t++) {
+        int o = state->touched[t];
+        heads[o] = 0;
+        depth[o] = 0;
+        int n = in_arcs(state, o, sources, weights);
+        for (int a = 0; a < n; a++) {
+            int p = sources[a];
+            if (state->affected[p] != state->stamp && improves(state, o, state->heads[p] + weights[a],
+                                                               state->depth[p] + 1)) {
+                heads[o] = state->heads[p] + weights[a];
+                depth[o] = state->depth[p] + 1;
             }
-        } else {
-            // Accept with a probability based on temperature and difference in makespan
-            double rand_num = (double)rand() / RAND_MAX;
-            double acceptance_prob = exp(-(current_makespan - best_makespan) / temperature);
-            if (rand_num < acceptance_prob) {
-                // Accept the neighbor solution
-                // Update best solution
-                for (int i = 0; i < n_jobs; i++) {
-                    best_solution[i] = current_solution[i];
+        }
+        state->arcs[o] = 0;
+        if (heads[o] + duration(o) > limit) {
+            heap_clear(state);
+            return heads[o] + duration(o);
+        }
+        heap_push(state, o, trial_rank(state, o));
+    }
+    // A seed that kept a tight arc may still rise along a new one
+    for (int s = 0; s < count; s++) {
+        int o = seeds[s];
+        if (state->affected[o] == state->stamp) {
+            continue;
+        }
+        int n = in_arcs(state, o, sources, weights);
+        for (int a = 0; a < n; a++) {
+            int p = sources[a];
+            int head = trial_head(state, p) + weights[a], arcs = trial_depth(state, p) + 1;
+            if (state->affected[p] != state->stamp && improves(state, o, head, arcs)) {
+                if (state->mark[o] != state->stamp) {
+                    touch(state, o);
                 }
-            } else {
-                // Revert current solution back to previous (no action needed)
+                heads[o] = head;
+                depth[o] = arcs;
+                state->arcs[o] = 0;
             }
         }
+        if (state->mark[o] == state->stamp && !state->waiting[o]) {
+            if (heads[o] + duration(o) > limit) {
+                heap_clear(state);
+                return heads[o] + duration(o);
+            }
+            heap_push(state, o, trial_rank(state, o));
+        }
+    }
+    while (state->heap_size > 0) {
+        int u = heap_pop(state);
+        int n = out_arcs(state, u, sources, weights);
+        for (int a = 0; a < n; a++) {
+            int v = sources[a];
+            if (!improves(state, v, heads[u] + weights[a], depth[u] + 1)) {
+                continue;
+            }
+            if (raise_head(state, v, u, heads[u] + weights[a], depth[u] + 1)) {
+                heap_clear(state);
+                return INFINITY;
+            }
+            if (heads[v] + duration(v) > limit) {
+                heap_clear(state);
+                return heads[v] + duration(v);
+            }
+            if (!state->waiting[v]) {
+                heap_push(state, v, trial_rank(state, v));
+            }
+        }
+    }
 
-        // Decrease temperature
-        temperature *= COOLING_RATE;
-
-        iter++;
+    // Every operation ends before the last one of its job
+    int makespan = 0;
+    for (int i = 0; i < num_jobs; i++) {
+        int last = (i + 1) * num_machines - 1;
+        int end = trial_head(state, last) + duration(last);
+        makespan = end > makespan ? end : makespan;
     }
+    state->trial_valid = 1;
+    state->trial_makespan = makespan;
+    return makespan;
+}
 
-    // Output the best solution found
-    printf("Best Makespan = %d\n", calculate_makespan(best_solution, n_jobs));
-    printf("Best Schedule:\n");
-    for (int i = 0; i < n_jobs; i++) {
-        printf("Job %d: ", i);
-        for (int j = 0; j < best_solution[i].num_operations; j++) {
-            printf("(M%d, %d) ", best_solution[i].operations[j].machine, best_solution[i].operations[j].processing_time);
+// Copy the heads of the last propagation into the solution and follow tight
+// arcs back from the operation that ends last for one critical path,
+// preferring the machine arc
+void commit_heads(SearchState *state) {
+    int sources[3], weights[3];
+    for (int t = 0; t < state->touches; t++) {
+        int o = state->touched[t];
+        state->heads[o] = state->trial_heads[o];
+        state->depth[o] = state->trial_depth[o];
+    }
+    for (int r = state->low; r <= state->high; r++) {
+        state->topological[r] = state->trial_topological[r];
+        state->rank[state->topological[r]] = r;
+    }
+    state->makespan = state->trial_makespan;
+    int end = 0;
+    for (int i = 0; i < num_jobs; i++) {
+        int last = (i + 1) * num_machines - 1;
+        if (state->heads[last] + duration(last) == state->makespan) {
+            end = last;
+            break;
         }
-        printf("\n");
     }
+    int length = 0;
+    for (int o = end; o >= 0;) {
+        state->path[length++] = o;
+        int n = in_arcs(state, o, sources, weights), next = -1;
+        for (int a = 0; a < n && next < 0; a++) {
+            int p = sources[a];
+            if (state->heads[p] + weights[a] == state->heads[o] && state->depth[p] + 1 == state->depth[o]) {
+                next = p;
+            }
+        }
+        o = next;
+    }
+    for (int i = 0; i < length / 2; i++) {
+        int temp = state->path[i];
+        state->path[i] = state->path[length - 1 - i];
+        state->path[length - 1 - i] = temp;
+    }
+    state->blocks = 0;
+    for (int i = 0; i < length;) {
+        int j = i + 1;
+        while (j < length && machine_successor(state, state->path[j - 1]) == state->path[j]) {
+            j++;
+        }
+        if (j - i >= 2) {
+            state->block_start[state->blocks] = i;
+            state->block_length[state->blocks] = j - i;
+            state->blocks++;
+        }
+        i = j;
+    }
+    state->trial_valid = 0;
 }
 
-// Main function
-int main() {
-    srand(time(NULL));  // Seed random number generator
+// Function to evaluate the current schedule: longest paths over the whole
+// network (the starting solution is always feasible)
+double solution_cost(void *data, double limit) {
+    SearchState *state = data;
+    (void)limit;
+    if (reorder_ranks(state, 0, num_operations - 1) != 0) {
+        return INFINITY;
+    }
+    // Every operation is affected: depth 1 is never matched by a tight arc
+    for (int o = 0; o < num_operations; o++) {
+        state->depth[o] = 1;
+        state->heads[o] = INT_MIN / 2;
+    }
+    double makespan = propagate(state, state->order, num_operations, INFINITY);
+    commit_heads(state);
+    return makespan;
+}
 
-    int n_jobs = 5;  // Number of jobs
-    Job jobs[MAX_JOBS];  // Array to store jobs
+// Pick a move on a critical block: an operation moves after the next one or
+// after the last one of its block, or before the previous one or the first.
+// Moves that close a positive cycle are costed as infeasible. Without a
+// block there is no move: no machine arc is critical, so the makespan is a
+// job's own length.
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    if (state->blocks == 0) {
+        return 0;
+    }
+    int block = sa_rng_below(rng, state->blocks);
+    const int *operations = &state->path[state->block_start[block]];
+    int length = state->block_length[block];
+    int pick = sa_rng_below(rng, 2 * (length - 1));
+    int far = sa_rng_below(rng, 2);
+    if (pick < length - 1) {
+        move->from = state->position[operations[pick]];
+        move->to = state->position[operations[far ? length - 1 : pick + 1]];
+    } else {
+        pick = pick - (length - 1) + 1;
+        move->from = state->position[operations[pick]];
+        move->to = state->position[operations[far ? 0 : pick - 1]];
+    }
+    return 1;
+}
 
-    // Example initialization of jobs (you can modify this based on your needs)
-    for (int i = 0; i < n_jobs; i++) {
-        jobs[i].num_operations = 3;  // Example: each job has 3 operations
-        for (int j = 0; j < jobs[i].num_operations; j++) {
-            jobs[i].operations[j].machine = j % 3;  // Example: alternate machines M0, M1, M2
-            jobs[i].operations[j].processing_time = rand() % 10 + 1;  // Random processing time (1 to 10)
-        }
+// Cost of a move: make it, rank the segment again, propagate the heads from
+// the operations whose incoming machine arcs change (the segment and the
+// one after it) and undo it. The results are kept for apply_move.
+double move_cost(void *data, const void *move_data, double limit) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    if (move->from == move->to) {
+        state->trial_valid = 0;
+        return state->makespan;
+    }
+    int first = move->from < move->to ? move->from : move->to;
+    int last = move->from < move->to ? move->to : move->from;
+    int machine = machine_of(state->order[first]);
+    int count = (last + 1 < machine_start[machine + 1] ? last + 1 : last) - first + 1;
+    int low = num_operations, high = 0;
+    for (int i = first; i <= last; i++) {
+        int rank = state->rank[state->order[i]];
+        low = rank < low ? rank : low;
+        high = rank > high ? rank : high;
     }
+    move_operation(state, move->from, move->to);
+    double cost = reorder_ranks(state, low, high) == 0 ? propagate(state, &state->order[first], count, limit)
+                                                        : INFINITY;
+    move_operation(state, move->to, move->from);
+    state->trial_move = *move;
+    return cost;
+}
 
-    // Apply simulated annealing to solve the JSPTL problem
-    simulated_annealing(jobs, n_jobs);
+// Apply an accepted move, reusing the heads its evaluation left when it was
+// the move evaluated last (with --candidates it may not be)
+void apply_move(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    if (move->from == move->to) {
+        return;
+    }
+    if (!state->trial_valid || state->trial_move.from != move->from || state->trial_move.to != move->to) {
+        move_cost(state, move, INFINITY);
+    }
+    move_operation(state, move->from, move->to);
+    commit_heads(state);
+}
 
-    return 0;
+// Function to record the current schedule as the best one
+void save_best_solution(void *data) {
+    SearchState *state = data;
+    memcpy(state->best_order, state->order, num_operations * sizeof(int));
+}
+
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    memcpy(to->order, from->order, num_operations * sizeof(int));
+    memcpy(to->best_order, from->best_order, num_operations * sizeof(int));
+    index_positions(to, 0, num_operations - 1);
+    to->trial_valid = 0;
+}
+
+void *clone_state(const void *data) {
+    SearchState *clone = malloc(sizeof(SearchState));
+    allocate_state(clone);
+    copy_state(clone, data);
+    return clone;
+}
+
+void destroy_state(void *data) {
+    SearchState *state = data;
+    sa_arena_free(&state->arena);
+    free(state);
+}
+
+// Function to start a restarted chain from a new random job order
+void restart_solution(void *data, sa_rng *rng) {
+    generate_initial_solution(data, rng);
+}
+
+// Simulated annealing algorithm
+void simulated_annealing(const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    allocate_state(&state);
+    generate_initial_solution(&state, rng);
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMP,
+        .cooling_rate = COOLING_RATE,
+        .min_temperature = 0.1,
+        .iterations_per_temperature = 100,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_solution,
+        .cost = solution_cost,
+        .propose = propose_move,
+        .evaluate = move_cost,
+        .apply = apply_move,
+        .save_best = save_best_solution,
+    };
+    int best_makespan = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
+
+    // Output the best solution found
+    memcpy(state.order, state.best_order, num_operations * sizeof(int));
+    index_positions(&state, 0, num_operations - 1);
+    solution_cost(&state, INFINITY);
+    printf("Best Makespan = %d\n", best_makespan);
+    printf("Best Schedule (machine, start):\n");
+    for (int i = 0; i < num_jobs; i++) {
+        printf("Job %d: ", i);
+        for (int j = 0; j < num_machines; j++) {
+            int o = i * num_machines + j;
+            printf("(M%d, %d) ", machine_of(o), state.heads[o]);
+        }
+        printf("\n");
+    }
+    sa_arena_free(&state.arena);
 }
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include "sa.h"
 
 #define MAX_JOBS 5
 #define MAX_MACHINES 3
@@ -23,28 +24,32 @@ typedef struct {
 } Job;
 
 // Function prototypes
-void initialize_jobs(Job jobs[], int num_jobs);
-int calculate_completion_time(Job jobs[], int sequence[]);
+void initialize_jobs(Job jobs[], int num_jobs, sa_rng *rng);
+int calculate_completion_time(Job jobs[], int sequence[], double limit);
 void print_jobs(Job jobs[], int num_jobs);
-int simulated_annealing(Job jobs[], int num_jobs, int best_sequence[]);
+int simulated_annealing(Job jobs[], int num_jobs, int best_sequence[], const sa_options *options, sa_rng *rng);
+
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
-int main() {
     Job jobs[MAX_JOBS];
     int best_sequence[MAX_JOBS];
     int i;
 
-    // Initialize random seed
-    srand(time(NULL));
-
     // Initialize jobs with random processing times
-    initialize_jobs(jobs, MAX_JOBS);
+    initialize_jobs(jobs, MAX_JOBS, &rng);
 
     // Print initial jobs data (for verification)
     printf("Initial jobs data:\n");
     print_jobs(jobs, MAX_JOBS);
 
     // Solve JSSP using Simulated Annealing
-    int min_completion_time = simulated_annealing(jobs, MAX_JOBS, best_sequence);
+    int min_completion_time = simulated_annealing(jobs, MAX_JOBS, best_sequence, &options, &rng);
 
     // Output the best sequence found
     printf("\nBest job sequence found:\n");
@@ -58,20 +63,20 @@ int main() {
 }
 
 // Initialize jobs with random processing times
-void initialize_jobs(Job jobs[], int num_jobs) {
+void initialize_jobs(Job jobs[], int num_jobs, sa_rng *rng) {
     int i, j, k;
     for (i = 0; i < num_jobs; i++) {
-        jobs[i].num_operations = rand() % MAX_MACHINES + 1; // Random number of operations per job
+        jobs[i].num_operations = sa_rng_below(rng, MAX_MACHINES) + 1; // Random number of operations per job
 
         // Initialize operations
         for (j = 0; j < jobs[i].num_operations; j++) {
             jobs[i].operations[j].machine = j % MAX_MACHINES; // Assign machines cyclically
-            jobs[i].operations[j].processing_time = rand() % 10 + 1;  // Random processing time between 1 to 10 units
+            jobs[i].operations[j].processing_time = sa_rng_below(rng, 10) + 1;  // Random processing time between 1 to 10 units
         }
 
         // Shuffle operations to simulate random sequences
         for (j = jobs[i].num_operations - 1; j > 0; j--) {
-            k = rand() % (j + 1);
+            k = sa_rng_below(rng, j + 1);
             Operation temp = jobs[i].operations[j];
             jobs[i].operations[j] = jobs[i].operations[k];
             jobs[i].operations[k] = temp;
@@ -91,8 +96,8 @@ void print_jobs(Job jobs[], int num_jobs) {
 }
 
 // Calculate total completion time for a given job sequence
-int calculate_completion_time(Job jobs[], int sequence[]) {
-    int completion_times[MAX_MACHINES] = {0};
+// The completion time only grows, so stop once it exceeds limit
+int calculate_completion_time(Job jobs[], int sequence[], double limit) {
     int job_start_time[MAX_JOBS] = {0};
     int machine_available_time[MAX_MACHINES] = {0};
     int i, j;
@@ -125,93 +130,109 @@ int calculate_completion_time(Job jobs[], int sequence[]) {
         // Update completion times for machines
         if (current_job_completion_time > max_completion_time) {
             max_completion_time = current_job_completion_time;
+            if (max_completion_time > limit) {
+                break;
+            }
         }
     }
 
     return max_completion_time;
 }
 
-// Simulated Annealing function to find the optimal job sequence
-int simulated_annealing(Job jobs[], int num_jobs, int best_sequence[]) {
+// Annealing state: instance, current sequence and best sequence
+typedef struct {
+    Job *jobs;
+    int num_jobs;
     int current_sequence[MAX_JOBS];
-    int new_sequence[MAX_JOBS];
-    int current_completion_time, new_completion_time;
-    int best_completion_time;
-    double temperature = INITIAL_TEMPERATURE;
-    double acceptance_probability;
-    int iteration, i, j;
-    int delta;
+    int best_sequence[MAX_JOBS];
+} SearchState;
 
-    // Initialize current sequence randomly
+// Move: swap the jobs at two positions
+typedef struct {
+    int i;
+    int j;
+} Move;
+
+// Evaluate the current sequence
+double sequence_cost(void *data, double limit) {
+    SearchState *state = data;
+    return calculate_completion_time(state->jobs, state->current_sequence, limit);
+}
+
+// Randomly choose two indices to swap
+int propose_swap(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    move->i = sa_rng_below(rng, state->num_jobs);
+    move->j = sa_rng_below(rng, state->num_jobs);
+    return 1;
+}
+
+// Swap two positions (a swap is its own undo)
+void swap_jobs(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int temp = state->current_sequence[move->i];
+    state->current_sequence[move->i] = state->current_sequence[move->j];
+    state->current_sequence[move->j] = temp;
+}
+
+// Record the current sequence as the best one
+void save_best_sequence(void *data) {
+    SearchState *state = data;
+    int i;
+    for (i = 0; i < state->num_jobs; i++) {
+        state->best_sequence[i] = state->current_sequence[i];
+    }
+}
+
+// Build a random job sequence
+void random_sequence(int sequence[], int num_jobs, sa_rng *rng) {
+    int i, j;
     for (i = 0; i < num_jobs; i++) {
-        current_sequence[i] = i;
+        sequence[i] = i;
     }
-    // Shuffle the initial sequence
+    // Shuffle the sequence
     for (i = num_jobs - 1; i > 0; i--) {
-        j = rand() % (i + 1);
-        int temp = current_sequence[i];
-        current_sequence[i] = current_sequence[j];
-        current_sequence[j] = temp;
+        j = sa_rng_below(rng, i + 1);
+        int temp = sequence[i];
+        sequence[i] = sequence[j];
+        sequence[j] = temp;
     }
+}
 
-    // Calculate initial completion time
-    current_completion_time = calculate_completion_time(jobs, current_sequence);
-    best_completion_time = current_completion_time;
-    // Copy the best sequence found so far
-    for (i = 0; i < num_jobs; i++) {
-        best_sequence[i] = current_sequence[i];
-    }
+// Start a restarted chain from a new random sequence
+void restart_sequence(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    random_sequence(state->current_sequence, state->num_jobs, rng);
+}
 
-    // Simulated Annealing loop
-    for (iteration = 1; iteration <= MAX_ITERATIONS; iteration++) {
-        // Generate a neighboring solution by swapping two jobs in the current sequence
-        for (i = 0; i < num_jobs; i++) {
-            new_sequence[i] = current_sequence[i];
-        }
-        // Randomly choose two indices to swap
-        i = rand() % num_jobs;
-        j = rand() % num_jobs;
-        // Swap
-        int temp = new_sequence[i];
-        new_sequence[i] = new_sequence[j];
-        new_sequence[j] = temp;
-
-        // Calculate the new completion time
-        new_completion_time = calculate_completion_time(jobs, new_sequence);
-
-        // Calculate delta E (change in objective function)
-        delta = new_completion_time - current_completion_time;
-
-        // Decide whether to accept the new solution
-        if (delta < 0) {
-            // If new solution is better, accept it
-            for (i = 0; i < num_jobs; i++) {
-                current_sequence[i] = new_sequence[i];
-            }
-            current_completion_time = new_completion_time;
-
-            // Update the best solution found so far
-            if (current_completion_time < best_completion_time) {
-                best_completion_time = current_completion_time;
-                for (i = 0; i < num_jobs; i++) {
-                    best_sequence[i] = current_sequence[i];
-                }
-            }
-        } else {
-            // If new solution is worse, accept it with a probability based on temperature
-            acceptance_probability = exp(-delta / temperature);
-            double rand_num = ((double) rand() / RAND_MAX);
-            if (rand_num < acceptance_probability) {
-                for (i = 0; i < num_jobs; i++) {
-                    current_sequence[i] = new_sequence[i];
-                }
-                current_completion_time = new_completion_time;
-            }
-        }
+// Simulated Annealing function to find the optimal job sequence
+int simulated_annealing(Job jobs[], int num_jobs, int best_sequence[], const sa_options *options, sa_rng *rng) {
+    SearchState state = {jobs, num_jobs, {0}, {0}};
+    int i;
 
-        // Cool the temperature
-        temperature *= COOLING_RATE;
+    // Initialize current sequence randomly
+    random_sequence(state.current_sequence, num_jobs, rng);
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMPERATURE,
+        .cooling_rate = COOLING_RATE,
+        .max_iterations = MAX_ITERATIONS,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .state_size = sizeof(SearchState),
+        .restart = restart_sequence,
+        .cost = sequence_cost,
+        .propose = propose_swap,
+        .apply = swap_jobs,
+        .undo = swap_jobs,
+        .save_best = save_best_sequence,
+    };
+    int best_cost = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
+    for (i = 0; i < num_jobs; i++) {
+        best_sequence[i] = state.best_sequence[i];
     }
-
-    return best_completion_time;
+    return best_cost;
 }
@@ -1,13 +1,19 @@
 // Multistage Flowshop Scheduling Problem (MFSP)
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
-#define MAX_STAGES 5
-#define MAX_JOBS 10
+#include "sa.h"
+#include "sa_instance.h"
+#include "sa_arena.h"
+#include "sa_batch.h"
+#include "sa_flowshop.h"
+#define EXAMPLE_STAGES 5
+#define EXAMPLE_JOBS 10
 
-// Define the processing times matrix
-int processing_times[MAX_JOBS][MAX_STAGES] = {
+// Processing times of the built-in example instance
+int example_times[EXAMPLE_JOBS][EXAMPLE_STAGES] = {
     {3, 2, 6, 5, 8},
     {2, 5, 3, 7, 4},
     {4, 2, 3, 6, 3},
@@ -20,104 +26,297 @@ int processing_times[MAX_JOBS][MAX_STAGES] = {
     {3, 6, 4, 5, 2}
 };
 
-// Function to calculate total completion time for a given sequence
-int calculate_completion_time(int sequence[]) {
-    int completion_times[MAX_JOBS][MAX_STAGES];
+// Problem instance: p[job * machines + stage] is the processing time
+sa_flowshop instance;
 
-    // Initialize first job's completion times
-    completion_times[0][0] = processing_times[sequence[0]][0];
-    for (int j = 1; j < MAX_STAGES; ++j) {
-        completion_times[0][j] = completion_times[0][j-1] + processing_times[sequence[0]][j];
-    }
+static inline int max_int(int a, int b) {
+    return a > b ? a : b;
+}
 
-    // Calculate completion times for subsequent jobs
-    for (int i = 1; i < MAX_JOBS; ++i) {
-        completion_times[i][0] = completion_times[i-1][0] + processing_times[sequence[i]][0];
-        for (int j = 1; j < MAX_STAGES; ++j) {
-            completion_times[i][j] = fmax(completion_times[i][j-1], completion_times[i-1][j]) + processing_times[sequence[i]][j];
+// Fill rows first.. of a completion matrix (completion[i * stages + j] is the
+// completion time of the i-th job of the sequence at stage j), taking row
+// first - 1 from previous; returns the total completion time.
+// The last stage's completion time only grows with each job, so the
+// calculation stops as soon as it exceeds limit
+int calculate_completion_times(const int sequence[], int first, const int *previous, int *completion, double limit) {
+    int stages = instance.machines;
+    const int *above = first > 0 ? &previous[(first - 1) * stages] : NULL;
+    for (int i = first; i < instance.jobs; ++i) {
+        const int *times = &instance.p[sequence[i] * stages];
+        int *row = &completion[i * stages];
+        if (above == NULL) {
+            row[0] = times[0];
+            for (int j = 1; j < stages; ++j) {
+                row[j] = row[j-1] + times[j];
+            }
+        } else {
+            row[0] = above[0] + times[0];
+            for (int j = 1; j < stages; ++j) {
+                row[j] = max_int(row[j-1], above[j]) + times[j];
+            }
+        }
+        if (row[stages-1] > limit) {
+            return row[stages-1];
         }
+        above = row;
     }
 
-    // Total completion time is the last completion time in the matrix
-    return completion_times[MAX_JOBS-1][MAX_STAGES-1];
+    // Total completion time is the completion time of the last job at the last stage
+    return completion[instance.jobs * stages - 1];
 }
 
-// Simulated Annealing Algorithm
-void simulated_annealing(int current_sequence[], double initial_temperature, double cooling_rate) {
-    int best_sequence[MAX_JOBS];
-    int current_cost, new_cost, best_cost;
+// Annealing state: sequence being improved, best sequence seen and the
+// completion matrix of the sequence, plus a second matrix that moves are
+// evaluated into; the four buffers share one arena. Batches of candidate
+// sequences and their makespans take buffers of their own, sized by the
+// first batch since the engine picks the batch size.
+typedef struct {
+    sa_arena arena;
+    int *sequence;
+    int *best_sequence;
+    int *completion;
+    int *trial;
+    int batch_capacity;
+    int *batch;
+    int *makespans;
+} SearchState;
+
+// Move: swap the jobs at two positions
+typedef struct {
+    int index1;
+    int index2;
+} Move;
+
+// Allocate the buffers of a search state in one block
+void allocate_state(SearchState *state) {
+    size_t sequence_size = instance.jobs * sizeof(int);
+    size_t matrix_size = instance.jobs * instance.machines * sizeof(int);
+    sa_arena_init(&state->arena, 2 * sa_arena_size(sequence_size) + 2 * sa_arena_size(matrix_size));
+    state->sequence = sa_arena_alloc(&state->arena, sequence_size);
+    state->best_sequence = sa_arena_alloc(&state->arena, sequence_size);
+    state->completion = sa_arena_alloc(&state->arena, matrix_size);
+    state->trial = sa_arena_alloc(&state->arena, matrix_size);
+    state->batch_capacity = 0;
+    state->batch = NULL;
+    state->makespans = NULL;
+}
+
+// Free the buffers of a search state
+void free_state(SearchState *state) {
+    sa_arena_free(&state->arena);
+    free(state->batch);
+    free(state->makespans);
+}
+
+// Evaluate the current sequence, rebuilding its whole completion matrix
+// (without stopping at limit, so the matrix is left complete)
+double sequence_cost(void *data, double limit) {
+    SearchState *state = data;
+    (void)limit;
+    return calculate_completion_times(state->sequence, 0, NULL, state->completion, INFINITY);
+}
 
-    // Initialize current sequence and costs
-    for (int i = 0; i < MAX_JOBS; ++i) {
-        best_sequence[i] = current_sequence[i];
+// Pick two different positions to swap
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    Move *move = move_data;
+    (void)data;
+    move->index1 = sa_rng_below(rng, instance.jobs);
+    move->index2 = sa_rng_below(rng, instance.jobs);
+    while (move->index1 == move->index2) {
+        move->index2 = sa_rng_below(rng, instance.jobs);
     }
-    current_cost = calculate_completion_time(current_sequence);
-    best_cost = current_cost;
-
-    // Simulated Annealing loop
-    double temperature = initial_temperature;
-    while (temperature > 1e-10) {
-        // Generate a neighboring solution by swapping two jobs
-        int index1 = rand() % MAX_JOBS;
-        int index2 = rand() % MAX_JOBS;
-        while (index1 == index2) {
-            index2 = rand() % MAX_JOBS;
-        }
-        int temp = current_sequence[index1];
-        current_sequence[index1] = current_sequence[index2];
-        current_sequence[index2] = temp;
-
-        // Calculate the cost of the new sequence
-        new_cost = calculate_completion_time(current_sequence);
-
-        // Decide if we should accept the new sequence
-        if (new_cost < current_cost) {
-            current_cost = new_cost;
-            if (current_cost < best_cost) {
-                best_cost = current_cost;
-                for (int i = 0; i < MAX_JOBS; ++i) {
-                    best_sequence[i] = current_sequence[i];
-                }
-            }
-        } else {
-            double probability = exp(-(new_cost - current_cost) / temperature);
-            if (rand() / (double)RAND_MAX < probability) {
-                current_cost = new_cost;
-            } else {
-                // Revert back to the previous sequence
-                temp = current_sequence[index1];
-                current_sequence[index1] = current_sequence[index2];
-                current_sequence[index2] = temp;
-            }
-        }
+    return 1;
+}
 
-        // Cool down the temperature
-        temperature *= cooling_rate;
+// Swap two positions of a sequence
+void swap_positions(int sequence[], const Move *move) {
+    int temp = sequence[move->index1];
+    sequence[move->index1] = sequence[move->index2];
+    sequence[move->index2] = temp;
+}
+
+// First position a swap changes
+int first_changed(const Move *move) {
+    return move->index1 < move->index2 ? move->index1 : move->index2;
+}
+
+// Evaluate a swap: the rows before its first position are unchanged, so only
+// the rows from there on are recomputed, into the trial matrix
+double swap_cost(void *data, const void *move_data, double limit) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    swap_positions(state->sequence, move);
+    int cost = calculate_completion_times(state->sequence, first_changed(move), state->completion, state->trial, limit);
+    swap_positions(state->sequence, move);
+    return cost;
+}
+
+// Evaluate a batch of swaps side by side: each candidate is the current
+// sequence with its swap made, and the positions before the earliest swapped
+// one are the same in all of them, so the kernel starts there from the
+// stored completion matrix
+void swap_costs(void *data, const void *moves_data, int count, double limit, double *costs) {
+    SearchState *state = data;
+    const Move *moves = moves_data;
+    int jobs = instance.jobs;
+    if (count > state->batch_capacity) {
+        state->batch_capacity = count;
+        state->batch = realloc(state->batch, count * jobs * sizeof(int));
+        state->makespans = realloc(state->makespans, count * sizeof(int));
+    }
+    int first = jobs;
+    for (int c = 0; c < count; ++c) {
+        int changed = first_changed(&moves[c]);
+        first = changed < first ? changed : first;
     }
+    for (int c = 0; c < count; ++c) {
+        int *candidate = &state->batch[c * jobs];
+        memcpy(&candidate[first], &state->sequence[first], (jobs - first) * sizeof(int));
+        swap_positions(candidate, &moves[c]);
+    }
+    const int *previous = first > 0 ? &state->completion[(first - 1) * instance.machines] : NULL;
+    sa_flowshop_batch(&instance, state->batch, count, first, previous, limit, state->makespans);
+    for (int c = 0; c < count; ++c) {
+        costs[c] = state->makespans[c];
+    }
+}
+
+// Accept a swap and bring the completion matrix up to date from its first
+// position
+void swap_jobs(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    swap_positions(state->sequence, move);
+    calculate_completion_times(state->sequence, first_changed(move), state->completion, state->completion, INFINITY);
+}
+
+// Record the current sequence as the best one
+void save_best_sequence(void *data) {
+    SearchState *state = data;
+    for (int i = 0; i < instance.jobs; ++i) {
+        state->best_sequence[i] = state->sequence[i];
+    }
+}
+
+// Copy the sequences and completion matrix of one search state into another
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    memcpy(to->sequence, from->sequence, instance.jobs * sizeof(int));
+    memcpy(to->best_sequence, from->best_sequence, instance.jobs * sizeof(int));
+    memcpy(to->completion, from->completion, instance.jobs * instance.machines * sizeof(int));
+}
+
+// Copy a search state for a restarted chain
+void *clone_state(const void *data) {
+    SearchState *clone = malloc(sizeof(SearchState));
+    allocate_state(clone);
+    copy_state(clone, data);
+    return clone;
+}
+
+// Free a cloned search state
+void destroy_state(void *data) {
+    SearchState *state = data;
+    free_state(state);
+    free(state);
+}
+
+// Start a restarted chain from a random permutation
+void restart_sequence(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    for (int i = instance.jobs - 1; i > 0; --i) {
+        int j = sa_rng_below(rng, i + 1);
+        int temp = state->sequence[i];
+        state->sequence[i] = state->sequence[j];
+        state->sequence[j] = temp;
+    }
+}
+
+// Simulated Annealing Algorithm
+void simulated_annealing(int current_sequence[], double initial_temperature, double cooling_rate, int random_restarts, const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    allocate_state(&state);
+    memcpy(state.sequence, current_sequence, instance.jobs * sizeof(int));
+
+    sa_params params = {
+        .initial_temperature = initial_temperature,
+        .cooling_rate = cooling_rate,
+        .min_temperature = 1e-10,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = random_restarts ? restart_sequence : NULL,
+        .cost = sequence_cost,
+        .propose = propose_move,
+        .evaluate = swap_cost,
+        .evaluate_batch = swap_costs,
+        .apply = swap_jobs,
+        .save_best = save_best_sequence,
+    };
+    int best_cost = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
 
     // Print the best sequence found
     printf("Best Sequence: ");
-    for (int i = 0; i < MAX_JOBS; ++i) {
-        printf("%d ", best_sequence[i]);
+    for (int i = 0; i < instance.jobs; ++i) {
+        printf("%d ", state.best_sequence[i]);
     }
     printf("\nBest Completion Time = %d\n", best_cost);
+    free_state(&state);
 }
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
-    // Initialize a random initial sequence
-    int initial_sequence[MAX_JOBS];
-    for (int i = 0; i < MAX_JOBS; ++i) {
-        initial_sequence[i] = i;
+    if (options.instance != NULL) {
+        if (sa_load_flowshop(options.instance, options.format, options.index, &instance) != 0) {
+            return 1;
+        }
+    } else {
+        instance.jobs = EXAMPLE_JOBS;
+        instance.machines = EXAMPLE_STAGES;
+        instance.p = malloc(sizeof(example_times));
+        memcpy(instance.p, example_times, sizeof(example_times));
+    }
+    if (instance.jobs < 2) {
+        fprintf(stderr, "MFSP needs at least two jobs\n");
+        return 1;
     }
 
     // Set initial temperature and cooling rate
     double initial_temperature = 1000.0;
     double cooling_rate = 0.99;
+    int random_restarts = 1;
+
+    // Start from the jobs in their input order, or from the NEH sequence at a
+    // temperature low enough not to undo it (restarted chains then start from
+    // it as well)
+    int *initial_sequence = malloc(instance.jobs * sizeof(int));
+    if (options.initial == NULL || strcmp(options.initial, "input") == 0) {
+        for (int i = 0; i < instance.jobs; ++i) {
+            initial_sequence[i] = i;
+        }
+    } else if (strcmp(options.initial, "neh") == 0) {
+        printf("NEH Completion Time = %d\n", sa_flowshop_neh(&instance, initial_sequence));
+        initial_temperature = sa_flowshop_temperature(&instance);
+        random_restarts = 0;
+    } else {
+        fprintf(stderr, "MFSP: unknown initial solution %s (input, neh)\n", options.initial);
+        return 1;
+    }
 
     // Run simulated annealing
-    simulated_annealing(initial_sequence, initial_temperature, cooling_rate);
+    simulated_annealing(initial_sequence, initial_temperature, cooling_rate, random_restarts, &options, &rng);
 
+    free(initial_sequence);
+    sa_free_flowshop(&instance);
     return 0;
 }
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
 
 #define MAX_JOBS 5
 #define MAX_OPERATIONS 3
@@ -23,17 +24,26 @@ int processing_time[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES] = {
 }; // Processing times
 
 // Function to generate a random initial solution
-void generate_initial_solution(int schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES]) {
-    srand(time(NULL));
+void generate_initial_solution(int schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES], sa_rng *rng) {
     for (int i = 0; i < n_jobs; ++i) {
         for (int j = 0; j < n_operations[i]; ++j) {
-            schedule[i][j][0] = rand() % MAX_MACHINES; // Random machine assignment
+            // Random machine order; the first entry is the assigned machine
+            for (int k = 0; k < MAX_MACHINES; ++k) {
+                schedule[i][j][k] = k;
+            }
+            for (int k = MAX_MACHINES - 1; k > 0; --k) {
+                int r = sa_rng_below(rng, k + 1);
+                int temp = schedule[i][j][k];
+                schedule[i][j][k] = schedule[i][j][r];
+                schedule[i][j][r] = temp;
+            }
         }
     }
 }
 
 // Function to calculate makespan for a given solution
-int calculate_makespan(int schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES]) {
+// Machine end times only grow, so stop once one of them exceeds limit
+int calculate_makespan(int schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES], double limit) {
     int machine_end_time[MAX_MACHINES] = {0};
     for (int i = 0; i < n_jobs; ++i) {
         for (int j = 0; j < n_operations[i]; ++j) {
@@ -41,6 +51,9 @@ int calculate_makespan(int schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES]) {
             int start_time = machine_end_time[machine];
             int end_time = start_time + processing_time[i][j][machine];
             machine_end_time[machine] = end_time;
+            if (end_time > limit) {
+                return end_time;
+            }
         }
     }
     int makespan = 0;
@@ -52,82 +65,98 @@ int calculate_makespan(int schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES]) {
     return makespan;
 }
 
-// Function to generate a neighbor solution
-void generate_neighbor(int current_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES],
-                       int neighbor_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES]) {
-    // Copy current solution to neighbor solution
+// Annealing state: current schedule and best schedule
+typedef struct {
+    int current_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES];
+    int best_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES];
+} SearchState;
+
+// Move: swap machines k1 and k2 for operation j of job i
+typedef struct {
+    int i;
+    int j;
+    int k1;
+    int k2;
+} Move;
+
+// Copy the operations of one schedule to another
+void copy_schedule(int dest[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES],
+                   int src[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES]) {
     for (int i = 0; i < n_jobs; ++i) {
         for (int j = 0; j < n_operations[i]; ++j) {
             for (int k = 0; k < MAX_MACHINES; ++k) {
-                neighbor_schedule[i][j][k] = current_schedule[i][j][k];
+                dest[i][j][k] = src[i][j][k];
             }
         }
     }
-
-    // Perform a random swap of machines for one operation
-    int i = rand() % n_jobs;
-    int j = rand() % n_operations[i];
-    int k1 = rand() % MAX_MACHINES;
-    int k2 = rand() % MAX_MACHINES;
-    // Swap machines k1 and k2 for job i, operation j
-    int temp = neighbor_schedule[i][j][k1];
-    neighbor_schedule[i][j][k1] = neighbor_schedule[i][j][k2];
-    neighbor_schedule[i][j][k2] = temp;
 }
 
-// Simulated annealing function to solve MOJSP
-void simulated_annealing(int initial_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES]) {
-    int current_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES];
-    int neighbor_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES];
+// Evaluate the current schedule
+double schedule_cost(void *data, double limit) {
+    SearchState *state = data;
+    return calculate_makespan(state->current_schedule, limit);
+}
 
-    // Initialize current schedule with initial solution
-    for (int i = 0; i < n_jobs; ++i) {
-        for (int j = 0; j < n_operations[i]; ++j) {
-            for (int k = 0; k < MAX_MACHINES; ++k) {
-                current_schedule[i][j][k] = initial_schedule[i][j][k];
-            }
-        }
+// Pick a random swap of two different machines for one operation
+int propose_swap(void *data, sa_rng *rng, void *move_data) {
+    Move *move = move_data;
+    (void)data;
+    move->i = sa_rng_below(rng, n_jobs);
+    move->j = sa_rng_below(rng, n_operations[move->i]);
+    move->k1 = sa_rng_below(rng, MAX_MACHINES);
+    move->k2 = sa_rng_below(rng, MAX_MACHINES);
+    while (move->k1 == move->k2) {
+        move->k2 = sa_rng_below(rng, MAX_MACHINES);
     }
+    return 1;
+}
 
-    double temperature = INITIAL_TEMPERATURE;
-    int current_makespan = calculate_makespan(current_schedule);
-    int best_makespan = current_makespan;
-    int best_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES];
-    int iteration = 0;
-
-    while (temperature > MIN_TEMPERATURE && iteration < MAX_ITERATIONS) {
-        generate_neighbor(current_schedule, neighbor_schedule);
-        int neighbor_makespan = calculate_makespan(neighbor_schedule);
-        int delta = neighbor_makespan - current_makespan;
-
-        if (delta < 0 || exp(-delta / temperature) > ((double)rand() / RAND_MAX)) {
-            // Accept the neighbor solution
-            for (int i = 0; i < n_jobs; ++i) {
-                for (int j = 0; j < n_operations[i]; ++j) {
-                    for (int k = 0; k < MAX_MACHINES; ++k) {
-                        current_schedule[i][j][k] = neighbor_schedule[i][j][k];
-                    }
-                }
-            }
-            current_makespan = neighbor_makespan;
-
-            // Update best solution found so far
-            if (current_makespan < best_makespan) {
-                best_makespan = current_makespan;
-                for (int i = 0; i < n_jobs; ++i) {
-                    for (int j = 0; j < n_operations[i]; ++j) {
-                        for (int k = 0; k < MAX_MACHINES; ++k) {
-                            best_schedule[i][j][k] = current_schedule[i][j][k];
-                        }
-                    }
-                }
-            }
-        }
+// Swap the two machines in place (a swap is its own undo)
+void swap_machines(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int *machines = state->current_schedule[move->i][move->j];
+    int temp = machines[move->k1];
+    machines[move->k1] = machines[move->k2];
+    machines[move->k2] = temp;
+}
 
-        // Cool down the temperature
-        temperature *= COOLING_RATE;
-        iteration++;
-    }
+// Record the current schedule as the best one
+void save_best_schedule(void *data) {
+    SearchState *state = data;
+    copy_schedule(state->best_schedule, state->current_schedule);
+}
+
+// Start a restarted chain from a new random schedule
+void restart_schedule(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    generate_initial_solution(state->current_schedule, rng);
+}
+
+// Simulated annealing function to solve MOJSP
+void simulated_annealing(int initial_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES], const sa_options *options, sa_rng *rng) {
+    SearchState state;
+
+    // Initialize current schedule with initial solution
+    copy_schedule(state.current_schedule, initial_schedule);
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMPERATURE,
+        .cooling_rate = COOLING_RATE,
+        .min_temperature = MIN_TEMPERATURE,
+        .max_iterations = MAX_ITERATIONS,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .state_size = sizeof(SearchState),
+        .restart = restart_schedule,
+        .cost = schedule_cost,
+        .propose = propose_swap,
+        .apply = swap_machines,
+        .undo = swap_machines,
+        .save_best = save_best_schedule,
+    };
+    int best_makespan = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
 
     // Output the best solution found
     printf("Best Makespan: %d\n", best_makespan);
@@ -135,16 +164,23 @@ void simulated_annealing(int initial_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACH
     for (int i = 0; i < n_jobs; ++i) {
         printf("Job %d: ", i + 1);
         for (int j = 0; j < n_operations[i]; ++j) {
-            printf("(Operation %d, Machine %d) ", j + 1, best_schedule[i][j][0] + 1);
+            printf("(Operation %d, Machine %d) ", j + 1, state.best_schedule[i][j][0] + 1);
         }
         printf("\n");
     }
 }
 
-int main() {
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
     int initial_schedule[MAX_JOBS][MAX_OPERATIONS][MAX_MACHINES];
 
-    generate_initial_solution(initial_schedule);
+    generate_initial_solution(initial_schedule, &rng);
 
     printf("Initial Schedule:\n");
     for (int i = 0; i < n_jobs; ++i) {
@@ -156,7 +192,7 @@ int main() {
     }
 
     printf("\nRunning Simulated Annealing...\n");
-    simulated_annealing(initial_schedule);
+    simulated_annealing(initial_schedule, &options, &rng);
 
     return 0;
 }
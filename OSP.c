@@ -1,19 +1,26 @@
 // Open-Shop Scheduling Problem (OSP)
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
+#include "sa_arena.h"
 #define MAX_JOBS 10  // Maximum number of jobs
 #define MAX_MACHINES 10  // Maximum number of machines
-// Function to calculate the makespan of a given solution
-int calculate_makespan(int **schedule, int n, int m, int *processing_times) {
-    int *finish_time = (int *)malloc(m * sizeof(int));
+// Function to calculate the makespan of a given solution (start time of job
+// i on machine j at i * m + j); finish_time is scratch space for m entries
+// Machine finish times only grow, so stop once one of them exceeds limit
+int calculate_makespan(const int *schedule, int n, int m, const int *processing_times, int *finish_time, double limit) {
     for (int i = 0; i < m; i++) {
         finish_time[i] = 0;
     }
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < m; j++) {
-            finish_time[j] = fmax(finish_time[j], schedule[i][j]) + processing_times[i * m + j];
+            finish_time[j] = fmax(finish_time[j], schedule[i * m + j]) + processing_times[i * m + j];
+            if (finish_time[j] > limit) {
+                return finish_time[j];
+            }
         }
     }
     int makespan = 0;
@@ -22,76 +29,146 @@ int calculate_makespan(int **schedule, int n, int m, int *processing_times) {
             makespan = finish_time[i];
         }
     }
-    free(finish_time);
     return makespan;
 }
 // Function to generate a random initial solution
-void generate_initial_solution(int **schedule, int n, int m, int *processing_times) {
+void generate_initial_solution(int *schedule, int n, int m, int *processing_times, sa_rng *rng) {
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < m; j++) {
-            schedule[i][j] = rand() % (n * m);  // Random initialization
+            schedule[i * m + j] = sa_rng_below(rng, n * m);  // Random initialization
         }
     }
 }
 // Function to copy a schedule from source to destination
-void copy_schedule(int **source, int **destination, int n, int m) {
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < m; j++) {
-            destination[i][j] = source[i][j];
-        }
-    }
+void copy_schedule(const int *source, int *destination, int n, int m) {
+    memcpy(destination, source, n * m * sizeof(int));
 }
-// Function to perform simulated annealing
-void simulated_annealing(int **schedule, int n, int m, int *processing_times, double initial_temperature, double cooling_rate) {
-    int **current_solution = (int **)malloc(n * sizeof(int *));
-    for (int i = 0; i < n; i++) {
-        current_solution[i] = (int *)malloc(m * sizeof(int));
-    }
-    int **best_solution = (int **)malloc(n * sizeof(int *));
-    for (int i = 0; i < n; i++) {
-        best_solution[i] = (int *)malloc(m * sizeof(int));
+// Annealing state: instance, then current and best start times and the
+// makespan scratch space, all carved from one arena per chain
+typedef struct {
+    int n, m;
+    int *processing_times;
+    sa_arena arena;
+    int *current_solution;
+    int *best_solution;
+    int *finish_time;
+} SearchState;
+// Function to allocate the buffers of a search state in one block
+void allocate_state(SearchState *state) {
+    size_t schedule_size = state->n * state->m * sizeof(int);
+    size_t scratch_size = state->m * sizeof(int);
+    sa_arena_init(&state->arena, 2 * sa_arena_size(schedule_size) + sa_arena_size(scratch_size));
+    state->current_solution = sa_arena_alloc(&state->arena, schedule_size);
+    state->best_solution = sa_arena_alloc(&state->arena, schedule_size);
+    state->finish_time = sa_arena_alloc(&state->arena, scratch_size);
+}
+// Move: swap the start times of one job on two machines
+typedef struct {
+    int job;
+    int machine1;
+    int machine2;
+} Move;
+// Function to evaluate the current solution
+double solution_cost(void *data, double limit) {
+    SearchState *state = data;
+    return calculate_makespan(state->current_solution, state->n, state->m, state->processing_times,
+                              state->finish_time, limit);
+}
+// Function to pick a job and two different machines
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    if (state->m < 2) {
+        return 0;
     }
-    generate_initial_solution(schedule, n, m, processing_times);
-    copy_schedule(schedule, current_solution, n, m);
-    copy_schedule(schedule, best_solution, n, m);
-    int current_makespan = calculate_makespan(current_solution, n, m, processing_times);
-    int best_makespan = current_makespan;
-    double temperature = initial_temperature;
-    srand(time(NULL));
-    while (temperature > 1.0) {
-        for (int i = 0; i < 100; i++) {  // Number of iterations at each temperature
-            int job = rand() % n;
-            int machine1 = rand() % m;
-            int machine2 = rand() % m;
-            int old_start_time = current_solution[job][machine1];
-current_solution[job][machine1] = current_solution[job][machine2];
-current_solution[job][machine2] = old_start_time;
-            int new_makespan = calculate_makespan(current_solution, n, m, processing_times);
-            int delta_makespan = new_makespan - current_makespan;
-            if (delta_makespan < 0 || exp(-delta_makespan / temperature) > ((double)rand() / RAND_MAX)) {
-current_makespan = new_makespan;
-                if (current_makespan < best_makespan) {
-best_makespan = current_makespan;
-copy_schedule(current_solution, best_solution, n, m);
-                }
-            } else {
-                // Revert back to the previous solution
-current_solution[job][machine2] = current_solution[job][machine1];    current_solution[job][machine1] = old_start_time;
-            }
-        }
-        temperature *= cooling_rate;  // Cooling the temperature
+    move->job = sa_rng_below(rng, state->n);
+    move->machine1 = sa_rng_below(rng, state->m);
+    move->machine2 = sa_rng_below(rng, state->m);
+    while (move->machine1 == move->machine2) {
+        move->machine2 = sa_rng_below(rng, state->m);
     }
+    return 1;
+}
+// Function to swap the start times of a move (a swap is its own undo)
+void swap_start_times(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int *row = &state->current_solution[move->job * state->m];
+    int old_start_time = row[move->machine1];
+    row[move->machine1] = row[move->machine2];
+    row[move->machine2] = old_start_time;
+}
+// Function to record the current solution as the best one
+void save_best_solution(void *data) {
+    SearchState *state = data;
+    copy_schedule(state->current_solution, state->best_solution, state->n, state->m);
+}
+// Function to copy a search state for a restarted chain
+void *clone_state(const void *data) {
+    const SearchState *state = data;
+    SearchState *clone = malloc(sizeof(SearchState));
+    *clone = *state;
+    allocate_state(clone);
+    copy_schedule(state->current_solution, clone->current_solution, state->n, state->m);
+    copy_schedule(state->best_solution, clone->best_solution, state->n, state->m);
+    return clone;
+}
+// Function to copy the solutions of one search state into another
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    copy_schedule(from->current_solution, to->current_solution, from->n, from->m);
+    copy_schedule(from->best_solution, to->best_solution, from->n, from->m);
+}
+// Function to free a cloned search state
+void destroy_state(void *data) {
+    SearchState *state = data;
+    sa_arena_free(&state->arena);
+    free(state);
+}
+// Function to start a restarted chain from new random start times
+void restart_solution(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    generate_initial_solution(state->current_solution, state->n, state->m, state->processing_times, rng);
+}
+// Function to perform simulated annealing
+void simulated_annealing(int *schedule, int n, int m, int *processing_times, double initial_temperature, double cooling_rate, const sa_options *options, sa_rng *rng) {
+    SearchState state = {.n = n, .m = m, .processing_times = processing_times};
+    allocate_state(&state);
+    generate_initial_solution(schedule, n, m, processing_times, rng);
+    copy_schedule(schedule, state.current_solution, n, m);
+    sa_params params = {
+        .initial_temperature = initial_temperature,
+        .cooling_rate = cooling_rate,
+        .min_temperature = 1.0,
+        .iterations_per_temperature = 100,  // Number of iterations at each temperature
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_solution,
+        .cost = solution_cost,
+        .propose = propose_move,
+        .apply = swap_start_times,
+        .undo = swap_start_times,
+        .save_best = save_best_solution,
+    };
+    sa_solve(&problem, &state, &params, options, rng, NULL);
     // Copy the best solution found to the output schedule
-copy_schedule(best_solution, schedule, n, m);
-    // Free dynamically allocated memory
-    for (int i = 0; i < n; i++) {
-free(current_solution[i]);
-        free(best_solution[i]);
-    }
-    free(current_solution);
-    free(best_solution);
+copy_schedule(state.best_solution, schedule, n, m);
+    // Free the search state
+    sa_arena_free(&state.arena);
 }
-int main() {
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
     // Problem parameters
     int n = 5;  // Number of jobs
     int m = 3;  // Number of machines
@@ -105,25 +182,19 @@ int main() {
         2, 5, 1,
         5, 2, 3
     };
-    // Allocate memory for the schedule
-    int **schedule = (int **)malloc(n * sizeof(int *));
-    for (int i = 0; i < n; i++) {
-        schedule[i] = (int *)malloc(m * sizeof(int));
-    }
-simulated_annealing(schedule, n, m, processing_times, initial_temperature, cooling_rate);
+    // Allocate memory for the schedule (start time of job i on machine j at i * m + j)
+    int *schedule = (int *)malloc(n * m * sizeof(int));
+simulated_annealing(schedule, n, m, processing_times, initial_temperature, cooling_rate, &options, &rng);
     // Print the optimal schedule found
     printf("\nOptimal Schedule:\n");
     for (int i = 0; i < n; i++) {
         printf("Job %d:", i + 1);
         for (int j = 0; j < m; j++) {
-            printf(" %d", schedule[i][j]);
+            printf(" %d", schedule[i * m + j]);
         }
         printf("\n");
     }
     // Free dynamically allocated memory
-    for (int i = 0; i < n; i++) {
-        free(schedule[i]);
-    }
     free(schedule);
     return 0;
 }
\ No newline at end of file
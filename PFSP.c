@@ -1,140 +1,306 @@
 // Permutation Flow Shop Problem (PFSP)
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
+#include "sa_instance.h"
+#include "sa_arena.h"
+#include "sa_flowshop.h"
 #define MAX_ITER 10000
 #define INITIAL_TEMP 100.0
 #define COOLING_RATE 0.95
-// Define constants for the problem
+// Size of the built-in example instance
 #define JOBS 3
 #define MACHINES 3
+// Problem instance: processing time of each job on each machine
+sa_flowshop instance;
 // Function prototypes
-void generateRandomSchedule(int schedule[JOBS][MACHINES]);
-int calculateMakespan(int schedule[JOBS][MACHINES]);
-void copySchedule(int from[JOBS][MACHINES], int to[JOBS][MACHINES]);
-void swapJobs(int schedule[JOBS][MACHINES], int job1, int job2);
-double acceptanceProbability(int currentMakespan, int newMakespan, double temperature);
-void simulatedAnnealing(int schedule[JOBS][MACHINES]);
-int main() {
-    srand(time(NULL));
-    int schedule[JOBS][MACHINES];
-    // Generate a random initial schedule
-generateRandomSchedule(schedule);
-    // Print the initial schedule
-    printf("Initial Schedule:\n");
-    for (int i = 0; i < JOBS; i++) {
-        for (int j = 0; j < MACHINES; j++) {
-            printf("%d ", schedule[i][j]);
+void generateRandomInstance(sa_flowshop *flowshop, sa_rng *rng);
+int calculateMakespan(const int *sequence, double limit);
+void printSchedule(const int *sequence);
+void swapJobs(int *sequence, int position1, int position2);
+void moveJob(int *sequence, int from, int to);
+void simulatedAnnealing(int *sequence, double initialTemperature, int randomRestarts, const sa_options *options,
+                        sa_rng *rng);
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
+    if (options.instance != NULL) {
+        if (sa_load_flowshop(options.instance, options.format, options.index, &instance) != 0) {
+            return 1;
         }
-        printf("\n");
+    } else {
+        // Generate a random example instance
+        generateRandomInstance(&instance, &rng);
     }
+    if (instance.jobs < 2) {
+        fprintf(stderr, "PFSP needs at least two jobs\n");
+        return 1;
+    }
+    // Start from the jobs in their input order, or from the NEH sequence at
+    // a temperature low enough not to undo it; restarted chains then start
+    // from it as well instead of from random orders
+    int *sequence = malloc(instance.jobs * sizeof(int));
+    double initialTemperature = INITIAL_TEMP;
+    int randomRestarts = 1;
+    if (options.initial == NULL || strcmp(options.initial, "input") == 0) {
+        for (int i = 0; i < instance.jobs; i++) {
+            sequence[i] = i;
+        }
+    } else if (strcmp(options.initial, "neh") == 0) {
+        printf("NEH Makespan = %d\n", sa_flowshop_neh(&instance, sequence));
+        initialTemperature = sa_flowshop_temperature(&instance);
+        randomRestarts = 0;
+    } else {
+        fprintf(stderr, "PFSP: unknown initial solution %s (input, neh)\n", options.initial);
+        return 1;
+    }
+    // Print the initial schedule
+    printf("Initial Schedule:\n");
+    printSchedule(sequence);
     // Run simulated annealing to find the optimal schedule
-simulatedAnnealing(schedule);
+simulatedAnnealing(sequence, initialTemperature, randomRestarts, &options, &rng);
     // Print the final optimal schedule found
     printf("\nOptimal Schedule:\n");
-    for (int i = 0; i < JOBS; i++) {
-        for (int j = 0; j < MACHINES; j++) {
-            printf("%d ", schedule[i][j]);
-        }
-        printf("\n");
-    }
+    printSchedule(sequence);
     // Print the makespan of the optimal schedule
-    int optimalMakespan = calculateMakespan(schedule);
+    int optimalMakespan = calculateMakespan(sequence, INFINITY);
     printf("\nOptimal Makespan = %d\n", optimalMakespan);
+    free(sequence);
+    sa_free_flowshop(&instance);
     return 0;
 }
-// Function to generate a random initial schedule
-void generateRandomSchedule(int schedule[JOBS][MACHINES]) {
+// Function to generate a random example instance
+void generateRandomInstance(sa_flowshop *flowshop, sa_rng *rng) {
+    flowshop->jobs = JOBS;
+    flowshop->machines = MACHINES;
+    flowshop->p = malloc(JOBS * MACHINES * sizeof(int));
     for (int i = 0; i < JOBS; i++) {
+        int *times = &flowshop->p[i * MACHINES];
         for (int j = 0; j < MACHINES; j++) {
-            schedule[i][j] = j + 1; // Random initial order
+            times[j] = j + 1; // Random processing times
         }
-        // Shuffle the jobs randomly
+        // Shuffle the times randomly
         for (int j = MACHINES - 1; j > 0; j--) {
-            int k = rand() % (j + 1);
-            int temp = schedule[i][j];
-            schedule[i][j] = schedule[i][k];
-            schedule[i][k] = temp;
+            int k = sa_rng_below(rng, j + 1);
+            int temp = times[j];
+            times[j] = times[k];
+            times[k] = temp;
         }
     }
 }
-// Function to calculate the makespan of a schedule
-int calculateMakespan(int schedule[JOBS][MACHINES]) {
-    int completionTimes[JOBS][MACHINES];
-    // Initialize the completion times matrix
-    completionTimes[0][0] = schedule[0][0];
-    for (int j = 1; j < MACHINES; j++) {
-        completionTimes[0][j] = completionTimes[0][j - 1] + schedule[0][j];
-    }
-    for (int i = 1; i < JOBS; i++) {
-        completionTimes[i][0] = completionTimes[i - 1][0] + schedule[i][0];
+// Function to calculate the makespan of a job sequence
+// The last machine's completion time only grows with each job, so the
+// calculation stops as soon as it exceeds limit
+int calculateMakespan(const int *sequence, double limit) {
+    int machines = instance.machines;
+    // Completion times of the previous job on each machine
+    int completionTimes[machines];
+    for (int j = 0; j < machines; j++) {
+        completionTimes[j] = 0;
     }
-    // Fill the rest of the completion times matrix
-    for (int i = 1; i < JOBS; i++) {
-        for (int j = 1; j < MACHINES; j++) {
-            completionTimes[i][j] = fmax(completionTimes[i - 1][j], completionTimes[i][j - 1]) + schedule[i][j];
+    for (int i = 0; i < instance.jobs; i++) {
+        const int *times = &instance.p[sequence[i] * machines];
+        completionTimes[0] += times[0];
+        for (int j = 1; j < machines; j++) {
+            completionTimes[j] = fmax(completionTimes[j], completionTimes[j - 1]) + times[j];
+        }
+        if (completionTimes[machines - 1] > limit) {
+            return completionTimes[machines - 1];
         }
     }
-    // Makespan is the last element in the completion times matrix
-    return completionTimes[JOBS - 1][MACHINES - 1];
+    // Makespan is the completion time of the last job on the last machine
+    return completionTimes[machines - 1];
 }
-// Function to copy one schedule to another
-void copySchedule(int from[JOBS][MACHINES], int to[JOBS][MACHINES]) {
-    for (int i = 0; i < JOBS; i++) {
-        for (int j = 0; j < MACHINES; j++) {
-            to[i][j] = from[i][j];
+// Function to print the processing times of the jobs in sequence order
+void printSchedule(const int *sequence) {
+    for (int i = 0; i < instance.jobs; i++) {
+        for (int j = 0; j < instance.machines; j++) {
+            printf("%d ", instance.p[sequence[i] * instance.machines + j]);
         }
+        printf("\n");
     }
 }
-// Function to swap two jobs in a schedule
-void swapJobs(int schedule[JOBS][MACHINES], int job1, int job2) {
-    for (int j = 0; j < MACHINES; j++) {
-        int temp = schedule[job1][j];
-        schedule[job1][j] = schedule[job2][j];
-        schedule[job2][j] = temp;
-    }
+// Function to swap two jobs in a sequence
+void swapJobs(int *sequence, int position1, int position2) {
+    int temp = sequence[position1];
+    sequence[position1] = sequence[position2];
+    sequence[position2] = temp;
 }
-// Function to calculate acceptance probability in simulated annealing
-double acceptanceProbability(int currentMakespan, int newMakespan, double temperature) {
-    if (newMakespan < currentMakespan) {
-        return 1.0; // Accept the new solution if it's better
+// Function to move the job at position from to position to, shifting the
+// jobs in between
+void moveJob(int *sequence, int from, int to) {
+    int job = sequence[from];
+    if (from < to) {
+        memmove(&sequence[from], &sequence[from + 1], (to - from) * sizeof(int));
+    } else {
+        memmove(&sequence[to + 1], &sequence[to], (from - to) * sizeof(int));
     }
-    return exp((currentMakespan - newMakespan) / temperature);
+    sequence[to] = job;
 }
-// Function implementing simulated annealing
-void simulatedAnnealing(int schedule[JOBS][MACHINES]) {
-    int currentMakespan = calculateMakespan(schedule);
-    int bestSchedule[JOBS][MACHINES];
-    copySchedule(schedule, bestSchedule);
-    int bestMakespan = currentMakespan;
-    double temperature = INITIAL_TEMP;
-    for (int iter = 1; iter <= MAX_ITER; iter++) {
-        // Generate a new neighboring solution by swapping two random jobs
-        int job1 = rand() % JOBS;
-        int job2 = rand() % JOBS;
-        while (job1 == job2) {
-            job2 = rand() % JOBS;
+// Annealing state: the sequence being improved, the best one seen and the
+// head and tail matrices of the insertion neighbourhood, in one arena
+typedef struct {
+    sa_arena arena;
+    int *sequence;
+    int *bestSequence;
+    int *heads; // heads[i * m + k]: completion of the first i + 1 remaining jobs on machine k
+    int *tails; // tails[i * m + k]: time from the start of remaining job i on machine k to the end
+} SearchState;
+// Move: take the job at position from out and reinsert it at position to
+typedef struct {
+    int from;
+    int to;
+    int makespan; // Makespan of the resulting sequence
+} Move;
+// Function to allocate the buffers of a search state in one block
+void allocateState(SearchState *state) {
+    size_t sequenceSize = instance.jobs * sizeof(int);
+    size_t matrixSize = instance.jobs * instance.machines * sizeof(int);
+    sa_arena_init(&state->arena, 2 * sa_arena_size(sequenceSize) + 2 * sa_arena_size(matrixSize));
+    state->sequence = sa_arena_alloc(&state->arena, sequenceSize);
+    state->bestSequence = sa_arena_alloc(&state->arena, sequenceSize);
+    state->heads = sa_arena_alloc(&state->arena, matrixSize);
+    state->tails = sa_arena_alloc(&state->arena, matrixSize);
+}
+// Function to evaluate the current sequence
+double scheduleCost(void *data, double limit) {
+    SearchState *state = data;
+    return calculateMakespan(state->sequence, limit);
+}
+// Function to pick a random job and its best new position (Taillard, 1990).
+// With the job taken out, heads and tails of the remaining n - 1 jobs give
+// the makespan of every insertion position in O(nm) in total: inserting at
+// position i finishes the job on machine k at f[k] = max(heads[i - 1][k],
+// f[k - 1]) + p[k], and the makespan is the largest f[k] + tails[i][k].
+int proposeMove(void *data, sa_rng *rng, void *moveData) {
+    SearchState *state = data;
+    Move *move = moveData;
+    int n = instance.jobs, m = instance.machines;
+    int *heads = state->heads, *tails = state->tails;
+    move->from = sa_rng_below(rng, n);
+    const int *job = &instance.p[state->sequence[move->from] * m];
+    // Remaining sequence: position i holds sequence[i], or sequence[i + 1] from the removed job on
+    for (int i = 0; i < n - 1; i++) {
+        const int *times = &instance.p[state->sequence[i < move->from ? i : i + 1] * m];
+        for (int k = 0; k < m; k++) {
+            int above = i > 0 ? heads[(i - 1) * m + k] : 0;
+            int left = k > 0 ? heads[i * m + k - 1] : 0;
+            heads[i * m + k] = (above > left ? above : left) + times[k];
         }
-        copySchedule(schedule, bestSchedule);
-        swapJobs(schedule, job1, job2);
-        // Calculate the makespan of the new solution
-        int newMakespan = calculateMakespan(schedule);
-        // Decide whether to accept the new solution
-        if (acceptanceProbability(currentMakespan, newMakespan, temperature) > ((double)rand() / RAND_MAX)) {
-            // Accept the new solution
-            currentMakespan = newMakespan;
-            if (currentMakespan < bestMakespan) {
-                bestMakespan = currentMakespan;
-                copySchedule(schedule, bestSchedule);
+    }
+    for (int i = n - 2; i >= 0; i--) {
+        const int *times = &instance.p[state->sequence[i < move->from ? i : i + 1] * m];
+        for (int k = m - 1; k >= 0; k--) {
+            int below = i < n - 2 ? tails[(i + 1) * m + k] : 0;
+            int right = k < m - 1 ? tails[i * m + k + 1] : 0;
+            tails[i * m + k] = (below > right ? below : right) + times[k];
+        }
+    }
+    move->to = -1;
+    for (int i = 0; i < n; i++) {
+        if (i == move->from) {
+            continue; // Reinserting the job where it was changes nothing
+        }
+        int finish = 0, makespan = 0;
+        for (int k = 0; k < m; k++) {
+            int above = i > 0 ? heads[(i - 1) * m + k] : 0;
+            finish = (above > finish ? above : finish) + job[k];
+            int end = finish + (i < n - 1 ? tails[i * m + k] : 0);
+            if (end > makespan) {
+                makespan = end;
             }
-        } else {
-            // Revert back to the previous solution
-copySchedule(bestSchedule, schedule);
         }
-        // Cool down the temperature
-        temperature *= COOLING_RATE;
+        if (move->to < 0 || makespan < move->makespan) {
+            move->to = i;
+            move->makespan = makespan;
+        }
+    }
+    return 1;
+}
+// Function to return the makespan computed with the move
+double moveCost(void *data, const void *moveData, double limit) {
+    const Move *move = moveData;
+    (void)data;
+    (void)limit;
+    return move->makespan;
+}
+// Function to apply an insertion
+void applyMove(void *data, const void *moveData) {
+    SearchState *state = data;
+    const Move *move = moveData;
+    moveJob(state->sequence, move->from, move->to);
+}
+// Function to record the current sequence as the best one
+void saveBest(void *data) {
+    SearchState *state = data;
+    for (int i = 0; i < instance.jobs; i++) {
+        state->bestSequence[i] = state->sequence[i];
+    }
+}
+// Function to copy the sequences of one search state into another
+void copyState(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    for (int i = 0; i < instance.jobs; i++) {
+        to->sequence[i] = from->sequence[i];
+        to->bestSequence[i] = from->bestSequence[i];
+    }
+}
+// Function to copy a search state for a restarted chain
+void *cloneState(const void *data) {
+    SearchState *clone = malloc(sizeof(SearchState));
+    allocateState(clone);
+    copyState(clone, data);
+    return clone;
+}
+// Function to free a cloned search state
+void destroyState(void *data) {
+    SearchState *state = data;
+    sa_arena_free(&state->arena);
+    free(state);
+}
+// Function to start a restarted chain from a random job order
+void restartSchedule(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    for (int i = instance.jobs - 1; i > 0; i--) {
+        swapJobs(state->sequence, i, sa_rng_below(rng, i + 1));
+    }
+}
+// Function implementing simulated annealing
+void simulatedAnnealing(int *sequence, double initialTemperature, int randomRestarts, const sa_options *options,
+                        sa_rng *rng) {
+    SearchState state;
+    allocateState(&state);
+    memcpy(state.sequence, sequence, instance.jobs * sizeof(int));
+    sa_params params = {
+        .initial_temperature = initialTemperature,
+        .cooling_rate = COOLING_RATE,
+        .max_iterations = MAX_ITER,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .clone = cloneState,
+        .copy = copyState,
+        .destroy = destroyState,
+        .restart = randomRestarts ? restartSchedule : NULL,
+        .cost = scheduleCost,
+        .propose = proposeMove,
+        .evaluate = moveCost,
+        .apply = applyMove,
+        .save_best = saveBest,
+    };
+    sa_solve(&problem, &state, &params, options, rng, NULL);
+    // Copy the best sequence found back to the original sequence
+    for (int i = 0; i < instance.jobs; i++) {
+        sequence[i] = state.bestSequence[i];
     }
-    // Copy the best schedule found back to the original schedule
-    copySchedule(bestSchedule, schedule);
+    sa_arena_free(&state.arena);
 }
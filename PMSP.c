@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
 #define MAX_MACHINES 3
 #define MAX_JOBS 5
 #define MAX_ITERATIONS 10000
@@ -24,19 +25,21 @@ int best_solution[MAX_JOBS];
 int best_cost;
 
 // Function prototypes
-void initialize();
-void generate_initial_solution();
-int calculate_cost(int solution[]);
-void simulated_annealing();
-void generate_neighbor_solution(int current_solution[]);
-double acceptance_probability(int delta_cost, double temperature);
-void update_solution(int new_solution[], int new_cost);
-
-int main() {
-    srand(time(NULL));
+void initialize(sa_rng *rng);
+void generate_initial_solution(int solution[], sa_rng *rng);
+int calculate_cost(int solution[], double limit);
+void simulated_annealing(const sa_options *options, sa_rng *rng);
+
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
-    initialize();
-    simulated_annealing();
+    initialize(&rng);
+    simulated_annealing(&options, &rng);
 
     printf("\nBest Solution Found:\n");
     for (int i = 0; i < num_jobs; i++) {
@@ -47,27 +50,30 @@ int main() {
     return 0;
 }
 
-void initialize() {
-    generate_initial_solution();
-    best_cost = calculate_cost(current_solution);
+void initialize(sa_rng *rng) {
+    generate_initial_solution(current_solution, rng);
+    best_cost = calculate_cost(current_solution, INFINITY);
     for (int i = 0; i < num_jobs; i++) {
         best_solution[i] = current_solution[i];
     }
 }
 
-void generate_initial_solution() {
+void generate_initial_solution(int solution[], sa_rng *rng) {
     // Generate a random initial solution
     for (int i = 0; i < num_jobs; i++) {
-        current_solution[i] = rand() % num_machines;
+        solution[i] = sa_rng_below(rng, num_machines);
     }
 }
 
-int calculate_cost(int solution[]) {
-    // Calculate the makespan (cost) of a given solution
+int calculate_cost(int solution[], double limit) {
+    // Calculate the makespan (cost) of a given solution, stopping once a load exceeds limit
     int machine_loads[MAX_MACHINES] = {0};
     for (int i = 0; i < num_jobs; i++) {
         int machine = solution[i];
         machine_loads[machine] += processing_times[machine][i];
+        if (machine_loads[machine] > limit) {
+            return machine_loads[machine];
+        }
     }
     int makespan = 0;
     for (int i = 0; i < num_machines; i++) {
@@ -78,52 +84,102 @@ int calculate_cost(int solution[]) {
     return makespan;
 }
 
-void simulated_annealing() {
-    double temperature = INITIAL_TEMPERATURE;
-    int current_cost = calculate_cost(current_solution);
-
-    for (int iter = 0; iter < MAX_ITERATIONS && temperature > MIN_TEMPERATURE; iter++) {
-        int neighbor_solution[MAX_JOBS];
-        generate_neighbor_solution(current_solution);
-        int neighbor_cost = calculate_cost(neighbor_solution);
-
-        int cost_diff = neighbor_cost - current_cost;
-
-        if (cost_diff < 0 || acceptance_probability(cost_diff, temperature) > ((double) rand() / RAND_MAX)) {
-            update_solution(neighbor_solution, neighbor_cost);
-            current_cost = neighbor_cost;
+// Annealing state: current and best job assignments
+typedef struct {
+    int current_solution[MAX_JOBS];
+    int best_solution[MAX_JOBS];
+} SearchState;
+
+// Move: a list of job reassignments, with the previous machines kept for undo
+typedef struct {
+    int count;
+    int job[MAX_JOBS];
+    int machine[MAX_JOBS];
+    int previous_machine[MAX_JOBS];
+} Move;
+
+double solution_cost(void *data, double limit) {
+    SearchState *state = data;
+    return calculate_cost(state->current_solution, limit);
+}
 
-            if (current_cost < best_cost) {
-                best_cost = current_cost;
-                for (int i = 0; i < num_jobs; i++) {
-                    best_solution[i] = current_solution[i];
+int propose_reassignments(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    // Generate a neighbor solution by randomly moving jobs between machines
+    move->count = 0;
+    for (int i = 0; i < num_jobs; i++) {
+        if (sa_rng_uniform(rng) < SWAP_PROBABILITY) {
+            int job = sa_rng_below(rng, num_jobs);
+            int previous = state->current_solution[job];
+            // A job may be moved twice; the later move undoes to the earlier target
+            for (int k = 0; k < move->count; k++) {
+                if (move->job[k] == job) {
+                    previous = move->machine[k];
                 }
             }
+            move->job[move->count] = job;
+            move->machine[move->count] = sa_rng_below(rng, num_machines);
+            move->previous_machine[move->count] = previous;
+            move->count++;
         }
+    }
+    return 1;
+}
 
-        temperature *= COOLING_RATE;
+void apply_reassignments(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    for (int i = 0; i < move->count; i++) {
+        state->current_solution[move->job[i]] = move->machine[i];
     }
 }
 
-void generate_neighbor_solution(int current_solution[]) {
-    // Generate a neighbor solution by randomly swapping jobs between machines
+void undo_reassignments(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    for (int i = move->count - 1; i >= 0; i--) {
+        state->current_solution[move->job[i]] = move->previous_machine[i];
+    }
+}
+
+void save_best_solution(void *data) {
+    SearchState *state = data;
     for (int i = 0; i < num_jobs; i++) {
-        if ((double) rand() / RAND_MAX < SWAP_PROBABILITY) {
-            int job = rand() % num_jobs;
-            int machine = rand() % num_machines;
-            current_solution[job] = machine;
-        }
+        state->best_solution[i] = state->current_solution[i];
     }
 }
 
-double acceptance_probability(int delta_cost, double temperature) {
-    // Calculate acceptance probability using Boltzmann distribution
-    return exp(-delta_cost / temperature);
+void restart_solution(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    generate_initial_solution(state->current_solution, rng);
 }
 
-void update_solution(int new_solution[], int new_cost) {
-    // Update current solution with a new solution
+void simulated_annealing(const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    for (int i = 0; i < num_jobs; i++) {
+        state.current_solution[i] = current_solution[i];
+    }
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMPERATURE,
+        .cooling_rate = COOLING_RATE,
+        .min_temperature = MIN_TEMPERATURE,
+        .max_iterations = MAX_ITERATIONS,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .state_size = sizeof(SearchState),
+        .restart = restart_solution,
+        .cost = solution_cost,
+        .propose = propose_reassignments,
+        .apply = apply_reassignments,
+        .undo = undo_reassignments,
+        .save_best = save_best_solution,
+    };
+    best_cost = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
+
     for (int i = 0; i < num_jobs; i++) {
-        current_solution[i] = new_solution[i];
+        best_solution[i] = state.best_solution[i];
     }
 }
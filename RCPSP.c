@@ -4,208 +4,609 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
+#include "sa_instance.h"
+#include "sa_profile.h"
 // Constants
-#define MAX_TASKS 10
-#define MAX_RESOURCES 5
 #define INITIAL_TEMPERATURE 1000.0
 #define COOLING_RATE 0.95
 #define MIN_TEMPERATURE 0.1
 #define MAX_ITERATIONS 1000
 
-// Task structure
+// Sort key of a task in a justification pass
 typedef struct {
-    int duration;
-    int resource_req[MAX_RESOURCES];
-    int num_successors;
-    int successors[MAX_TASKS];
-} Task;
+    int key;
+    int tie;
+    int task;
+} TaskKey;
 
-// Global variables
+// Global variables. The tasks are the activities of project, kept as its
+// arrays: a task runs in one of its modes, and mode m takes
+// project.duration[m] and project.request[m * num_resources ...]. Its
+// predecessors are predecessors[predecessor_start[t] ..
+// predecessor_start[t + 1] - 1], laid out like project.successors.
+sa_project project;
 int num_tasks;
-Task tasks[MAX_TASKS];
-int resource_avail[MAX_RESOURCES];
+int num_resources;
+int num_nonrenewables;
+int *resource_avail;
+int *predecessor_start;
+int *predecessors;
+int *multi_mode; // Tasks with more than one mode
+int num_multi_mode;
+int horizon;     // Sum of the longest durations: no serial schedule ends later
+int penalty;     // Cost of each unit of nonrenewable resource over its budget
 
 // Function prototypes
 void initialize();
-int calculate_makespan(int schedule[]);
-void generate_neighbor(int current_schedule[], int neighbor_schedule[]);
-double acceptance_probability(int energy, int new_energy, double temperature);
-void simulated_annealing();
-void print_schedule(int schedule[]);
-
-int main() {
-    initialize();
-    simulated_annealing();
+int build_tasks();
+void simulated_annealing(const sa_options *options, sa_rng *rng);
+
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
+    if (options.instance != NULL) {
+        if (sa_load_project(options.instance, options.format, options.index, &project) != 0) {
+            return 1;
+        }
+    } else {
+        initialize();
+    }
+    if (build_tasks() != 0) {
+        fprintf(stderr, "An activity requests more of a resource than its capacity\n");
+        return 1;
+    }
+    simulated_annealing(&options, &rng);
+    free(predecessor_start);
+    free(predecessors);
+    free(multi_mode);
+    sa_free_project(&project);
     return 0;
 }
 
 // Initialize tasks and resources
 void initialize() {
-    srand(time(NULL)); // Initialize random seed
-
-    // Example data for tasks and resource availability
-    num_tasks = 5;
-
-    tasks[0].duration = 3;
-    tasks[0].num_successors = 1;
-    tasks[0].successors[0] = 1;
-    tasks[0].resource_req[0] = 1;
-    tasks[0].resource_req[1] = 0;
-    tasks[0].resource_req[2] = 0;
-    tasks[0].resource_req[3] = 0;
-    tasks[0].resource_req[4] = 0;
-
-    tasks[1].duration = 5;
-    tasks[1].num_successors = 1;
-    tasks[1].successors[0] = 2;
-    tasks[1].resource_req[0] = 0;
-    tasks[1].resource_req[1] = 2;
-    tasks[1].resource_req[2] = 1;
-    tasks[1].resource_req[3] = 0;
-    tasks[1].resource_req[4] = 0;
-
-    tasks[2].duration = 2;
-    tasks[2].num_successors = 1;
-    tasks[2].successors[0] = 3;
-    tasks[2].resource_req[0] = 0;
-    tasks[2].resource_req[1] = 0;
-    tasks[2].resource_req[2] = 1;
-    tasks[2].resource_req[3] = 0;
-    tasks[2].resource_req[4] = 0;
-
-    tasks[3].duration = 4;
-    tasks[3].num_successors = 1;
-    tasks[3].successors[0] = 4;
-    tasks[3].resource_req[0] = 1;
-    tasks[3].resource_req[1] = 1;
-    tasks[3].resource_req[2] = 0;
-    tasks[3].resource_req[3] = 0;
-    tasks[3].resource_req[4] = 0;
-
-    tasks[4].duration = 1;
-    tasks[4].num_successors = 0;
-    tasks[4].resource_req[0] = 0;
-    tasks[4].resource_req[1] = 0;
-    tasks[4].resource_req[2] = 0;
-    tasks[4].resource_req[3] = 1;
-    tasks[4].resource_req[4] = 1;
-
-    // Initialize resource availability
-    resource_avail[0] = 2; // Resource R1
-    resource_avail[1] = 3; // Resource R2
-    resource_avail[2] = 2; // Resource R3
-    resource_avail[3] = 1; // Resource R4
-    resource_avail[4] = 1; // Resource R5
-}
-
-// Calculate makespan of a schedule
-int calculate_makespan(int schedule[]) {
-    int start_time[MAX_TASKS] = {0};
-    int end_time[MAX_TASKS] = {0};
 
+    // Example data for tasks and resource availability: one project, one
+    // mode per task and no nonrenewable resources
+    int durations[] = {3, 5, 2, 4, 1};
+    int successor_start[] = {0, 1, 2, 3, 4, 4};
+    int successors[] = {1, 2, 3, 4};
+    int requests[] = {
+        1, 0, 0, 0, 0,
+        0, 2, 1, 0, 0,
+        0, 0, 1, 0, 0,
+        1, 1, 0, 0, 0,
+        0, 0, 0, 1, 1
+    };
+    int capacities[] = {2, 3, 2, 1, 1}; // Resources R1 to R5
+    int mode_start[] = {0, 1, 2, 3, 4, 5};
+    int project_start[] = {0, 5};
+
+    memset(&project, 0, sizeof(project));
+    project.activities = 5;
+    project.resources = 5;
+    project.projects = 1;
+    project.duration = malloc(sizeof(durations));
+    project.successor_start = malloc(sizeof(successor_start));
+    project.successors = malloc(sizeof(successors));
+    project.request = malloc(sizeof(requests));
+    project.capacity = malloc(sizeof(capacities));
+    project.mode_start = malloc(sizeof(mode_start));
+    project.project_start = malloc(sizeof(project_start));
+    project.consumption = malloc(sizeof(int));
+    project.budget = malloc(sizeof(int));
+    memcpy(project.duration, durations, sizeof(durations));
+    memcpy(project.successor_start, successor_start, sizeof(successor_start));
+    memcpy(project.successors, successors, sizeof(successors));
+    memcpy(project.request, requests, sizeof(requests));
+    memcpy(project.capacity, capacities, sizeof(capacities));
+    memcpy(project.mode_start, mode_start, sizeof(mode_start));
+    memcpy(project.project_start, project_start, sizeof(project_start));
+}
+
+// Index the project: predecessor lists, tasks with a choice of mode and the
+// horizon; returns -1 if a mode requests more of a resource than its capacity
+int build_tasks() {
+    num_tasks = project.activities;
+    num_resources = project.resources;
+    num_nonrenewables = project.nonrenewables;
+    resource_avail = project.capacity;
+    predecessor_start = calloc(num_tasks + 1, sizeof(int));
+    predecessors = malloc((project.successor_start[num_tasks] + 1) * sizeof(int));
+    multi_mode = malloc(num_tasks * sizeof(int));
+    num_multi_mode = 0;
+    horizon = 0;
     for (int i = 0; i < num_tasks; ++i) {
-        int task_index = schedule[i];
-        int task_duration = tasks[task_index].duration;
-        int earliest_start = 0;
-
-        // Calculate earliest start time considering predecessors
-        for (int j = 0; j < tasks[task_index].num_successors; ++j) {
-            int successor_index = tasks[task_index].successors[j];
-            int finish_time = end_time[successor_index];
-            if (finish_time > earliest_start) {
-                earliest_start = finish_time;
+        for (int j = project.successor_start[i]; j < project.successor_start[i + 1]; ++j) {
+            predecessor_start[project.successors[j] + 1]++;
+        }
+        int longest = 0;
+        for (int m = project.mode_start[i]; m < project.mode_start[i + 1]; ++m) {
+            longest = project.duration[m] > longest ? project.duration[m] : longest;
+            for (int r = 0; r < num_resources; ++r) {
+                if (project.request[m * num_resources + r] > resource_avail[r]) {
+                    return -1;
+                }
             }
         }
-
-        // Calculate end time and update resource availability
-        int allocated_resources[MAX_RESOURCES] = {0};
-        for (int r = 0; r < MAX_RESOURCES; ++r) {
-            allocated_resources[r] = resource_avail[r];
+        horizon += longest;
+        if (project.mode_start[i + 1] - project.mode_start[i] > 1) {
+            multi_mode[num_multi_mode++] = i;
+        }
+    }
+    for (int i = 0; i < num_tasks; ++i) {
+        predecessor_start[i + 1] += predecessor_start[i];
+    }
+    int fill[num_tasks];
+    memcpy(fill, predecessor_start, num_tasks * sizeof(int));
+    for (int i = 0; i < num_tasks; ++i) {
+        for (int j = project.successor_start[i]; j < project.successor_start[i + 1]; ++j) {
+            predecessors[fill[project.successors[j]]++] = i;
         }
+    }
+    // Any schedule that keeps to the budgets is cheaper than one that does not
+    penalty = horizon + 1;
+    return 0;
+}
 
-        for (int t = earliest_start; t < earliest_start + task_duration; ++t) {
-            for (int r = 0; r < MAX_RESOURCES; ++r) {
-                allocated_resources[r] -= tasks[task_index].resource_req[r];
-                if (allocated_resources[r] < 0) {
-                    allocated_resources[r] = 0;
-                }
-            }
+// Annealing state: current and best activity lists, in which every task
+// comes after its predecessors, and modes, with the scratch of the schedule
+// generation
+typedef struct {
+    int *current_schedule;
+    int *best_schedule;
+    int *mode;        // Mode of each task
+    int *best_mode;
+    int *position;    // Place of each task in current_schedule
+    int *used;        // Use of each nonrenewable resource by the current modes
+    int excess;       // Units of nonrenewable resources used over their budgets
+    int *start_time;
+    int *late_start;  // Starts of the backward pass of a justification, in reversed time
+    int *ready;       // Latest end of the scheduled predecessors of each task
+    int *list;        // List built by a justification
+    TaskKey *keys;
+    sa_profile profile;
+} SearchState;
+
+// Serial schedule generation: take the tasks in list order and start each
+// one at the earliest time its predecessors and the resource profile allow.
+// Backward, the list is taken as an order of the reversed project, in which
+// successors come first and times run from the end. Fills start and returns
+// the makespan, stopping once a task ends after limit.
+int serial_schedule(SearchState *state, const int list[], int backward, double limit, int start[]) {
+    int done = 0, makespan = 0;
+    memset(state->ready, 0, num_tasks * sizeof(int));
+    while (done < num_tasks && makespan <= limit) {
+        int task = list[done++], mode = state->mode[task];
+        const int *request = &project.request[mode * num_resources];
+        int begin = sa_profile_earliest(&state->profile, request, project.duration[mode], state->ready[task]);
+        sa_profile_reserve(&state->profile, request, begin, project.duration[mode]);
+        start[task] = begin;
+        int end = begin + project.duration[mode];
+        makespan = end > makespan ? end : makespan;
+        int first = backward ? predecessor_start[task] : project.successor_start[task];
+        int last = backward ? predecessor_start[task + 1] : project.successor_start[task + 1];
+        const int *next = backward ? predecessors : project.successors;
+        for (int j = first; j < last; ++j) {
+            state->ready[next[j]] = end > state->ready[next[j]] ? end : state->ready[next[j]];
         }
+    }
 
-        start_time[task_index] = earliest_start;
-        end_time[task_index] = earliest_start + task_duration;
+    // Leave the profile empty for the next schedule
+    for (int i = 0; i < done; ++i) {
+        int mode = state->mode[list[i]];
+        sa_profile_release(&state->profile, &project.request[mode * num_resources], start[list[i]],
+                           project.duration[mode]);
     }
+    return makespan;
+}
 
-    // Find the makespan
-    int makespan = 0;
+// Calculate makespan of a schedule, stopping once a task ends after limit
+int calculate_makespan(SearchState *state, const int schedule[], double limit) {
+    return serial_schedule(state, schedule, 0, limit, state->start_time);
+}
+
+// Increasing key, then increasing tie
+static int by_key(const void *a, const void *b) {
+    const TaskKey *x = a, *y = b;
+    if (x->key != y->key) {
+        return x->key < y->key ? -1 : 1;
+    }
+    return x->tie < y->tie ? -1 : x->tie > y->tie;
+}
+
+// Sort the tasks by key, writing them to list
+static void sort_tasks(SearchState *state, int list[]) {
+    qsort(state->keys, num_tasks, sizeof(TaskKey), by_key);
     for (int i = 0; i < num_tasks; ++i) {
-        if (end_time[i] > makespan) {
-            makespan = end_time[i];
+        list[i] = state->keys[i].task;
+    }
+}
+
+// Forward-backward improvement (justification, Valls et al., 2005): shift
+// every task of the schedule as late as it can go, latest finish first, then
+// back as early as it can go, earliest of those starts first. Neither pass
+// lengthens the schedule, and the passes repeat while they shorten it. The
+// current list becomes the order of the last forward pass; the modes stay.
+// Returns the new cost.
+double justify_schedule(void *data, double cost) {
+    SearchState *state = data;
+    int extra = penalty * state->excess;
+    int makespan = (int)cost - extra;
+    calculate_makespan(state, state->current_schedule, INFINITY);
+    for (;;) {
+        // A successor finishes no earlier; on ties it is later in the list
+        for (int i = 0; i < num_tasks; ++i) {
+            int task = state->current_schedule[i];
+            int end = state->start_time[task] + project.duration[state->mode[task]];
+            state->keys[i] = (TaskKey){-end, -i, task};
         }
+        sort_tasks(state, state->list);
+        serial_schedule(state, state->list, 1, INFINITY, state->late_start);
+        // Earliest start of the right-justified schedule first; a
+        // predecessor came later in the backward list on ties
+        for (int i = 0; i < num_tasks; ++i) {
+            int task = state->list[i];
+            int end = state->late_start[task] + project.duration[state->mode[task]];
+            state->keys[i] = (TaskKey){-end, -i, task};
+        }
+        sort_tasks(state, state->list);
+        int forward = serial_schedule(state, state->list, 0, makespan - 1, state->start_time);
+        if (forward >= makespan) {
+            break;
+        }
+        makespan = forward;
+        memcpy(state->current_schedule, state->list, num_tasks * sizeof(int));
+    }
+    for (int i = 0; i < num_tasks; ++i) {
+        state->position[state->current_schedule[i]] = i;
     }
+    return makespan + extra;
+}
 
-    return makespan;
+// Move: take the task at position from out of the list and put it back at
+// to, or, when task is not -1, switch task from mode previous to mode
+typedef struct {
+    int from;
+    int to;
+    int task;
+    int mode;
+    int previous;
+} Move;
+
+// Evaluate the current schedule: its makespan, plus a penalty for every
+// unit of nonrenewable resource the modes use over the budgets
+double schedule_cost(void *data, double limit) {
+    SearchState *state = data;
+    int extra = penalty * state->excess;
+    return calculate_makespan(state, state->current_schedule, limit - extra) + extra;
 }
 
-// Generate a neighboring solution (schedule)
-void generate_neighbor(int current_schedule[], int neighbor_schedule[]) {
-    memcpy(neighbor_schedule, current_schedule, sizeof(int) * MAX_TASKS);
-    int idx1 = rand() % num_tasks;
-    int idx2 = rand() % num_tasks;
-    int temp = neighbor_schedule[idx1];
-    neighbor_schedule[idx1] = neighbor_schedule[idx2];
-    neighbor_schedule[idx2] = temp;
+// Either give a task with several modes another one, or pick a task and a
+// new place for it between its last predecessor and its first successor, so
+// that the list stays in precedence order. A task with no other such place
+// gives no move.
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    move->task = -1;
+    if (num_multi_mode > 0 && sa_rng_below(rng, 2) == 0) {
+        int task = multi_mode[sa_rng_below(rng, num_multi_mode)];
+        int first = project.mode_start[task], count = project.mode_start[task + 1] - first;
+        move->task = task;
+        move->previous = state->mode[task];
+        move->mode = first + (move->previous - first + 1 + sa_rng_below(rng, count - 1)) % count;
+        return 1;
+    }
+    move->from = sa_rng_below(rng, num_tasks);
+    int task = state->current_schedule[move->from];
+    int first = 0, last = num_tasks - 1;
+    for (int j = predecessor_start[task]; j < predecessor_start[task + 1]; ++j) {
+        int after = state->position[predecessors[j]] + 1;
+        first = after > first ? after : first;
+    }
+    for (int j = project.successor_start[task]; j < project.successor_start[task + 1]; ++j) {
+        int before = state->position[project.successors[j]] - 1;
+        last = before < last ? before : last;
+    }
+    if (last == first) {
+        return 0;
+    }
+    move->to = first + sa_rng_below(rng, last - first);
+    if (move->to >= move->from) {
+        move->to++;
+    }
+    return 1;
 }
 
-// Calculate acceptance probability for simulated annealing
-double acceptance_probability(int energy, int new_energy, double temperature) {
-    if (new_energy < energy) {
-        return 1.0;
+// Move the task at position from to position to, shifting the ones between
+static void shift_task(SearchState *state, int from, int to) {
+    int *list = state->current_schedule;
+    int task = list[from];
+    if (from < to) {
+        memmove(&list[from], &list[from + 1], (to - from) * sizeof(int));
+    } else {
+        memmove(&list[to + 1], &list[to], (from - to) * sizeof(int));
+    }
+    list[to] = task;
+    for (int i = from < to ? from : to; i <= (from < to ? to : from); ++i) {
+        state->position[list[i]] = i;
     }
-    return exp((energy - new_energy) / temperature);
 }
 
-// Simulated annealing algorithm
-void simulated_annealing() {
-    int current_schedule[MAX_TASKS];
-    int best_schedule[MAX_TASKS];
-    int current_makespan, best_makespan;
-    double temperature = INITIAL_TEMPERATURE;
+// Put a task in another mode, updating the nonrenewable use and its excess
+static void set_mode(SearchState *state, int task, int mode) {
+    const int *old = &project.consumption[state->mode[task] * num_nonrenewables];
+    const int *new = &project.consumption[mode * num_nonrenewables];
+    for (int k = 0; k < num_nonrenewables; ++k) {
+        int before = state->used[k] - project.budget[k];
+        state->used[k] += new[k] - old[k];
+        int after = state->used[k] - project.budget[k];
+        state->excess += (after > 0 ? after : 0) - (before > 0 ? before : 0);
+    }
+    state->mode[task] = mode;
+}
+
+void apply_move(void *data, const void *move_data) {
+    const Move *move = move_data;
+    if (move->task >= 0) {
+        set_mode(data, move->task, move->mode);
+    } else {
+        shift_task(data, move->from, move->to);
+    }
+}
 
-    // Initialize current schedule randomly
+void undo_move(void *data, const void *move_data) {
+    const Move *move = move_data;
+    if (move->task >= 0) {
+        set_mode(data, move->task, move->previous);
+    } else {
+        shift_task(data, move->to, move->from);
+    }
+}
+
+// Record the current schedule as the best one
+void save_best_schedule(void *data) {
+    SearchState *state = data;
+    memcpy(state->best_schedule, state->current_schedule, sizeof(int) * num_tasks);
+    memcpy(state->best_mode, state->mode, sizeof(int) * num_tasks);
+}
+
+// Allocate the schedules of a search state
+void allocate_state(SearchState *state) {
+    state->current_schedule = malloc(sizeof(int) * num_tasks);
+    state->best_schedule = malloc(sizeof(int) * num_tasks);
+    state->mode = malloc(sizeof(int) * num_tasks);
+    state->best_mode = malloc(sizeof(int) * num_tasks);
+    state->position = malloc(sizeof(int) * num_tasks);
+    state->used = malloc(sizeof(int) * (num_nonrenewables + 1));
+    state->start_time = malloc(sizeof(int) * num_tasks);
+    state->late_start = malloc(sizeof(int) * num_tasks);
+    state->ready = malloc(sizeof(int) * num_tasks);
+    state->list = malloc(sizeof(int) * num_tasks);
+    state->keys = malloc(sizeof(TaskKey) * num_tasks);
+    if (sa_profile_init(&state->profile, num_resources, horizon, resource_avail) != 0) {
+        fprintf(stderr, "Out of memory for the resource profile\n");
+        exit(1);
+    }
+}
+
+// Copy the schedules of one search state into another
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    memcpy(to->current_schedule, from->current_schedule, sizeof(int) * num_tasks);
+    memcpy(to->best_schedule, from->best_schedule, sizeof(int) * num_tasks);
+    memcpy(to->mode, from->mode, sizeof(int) * num_tasks);
+    memcpy(to->best_mode, from->best_mode, sizeof(int) * num_tasks);
+    memcpy(to->position, from->position, sizeof(int) * num_tasks);
+    memcpy(to->used, from->used, sizeof(int) * num_nonrenewables);
+    to->excess = from->excess;
+}
+
+// Copy a search state for a restarted chain
+void *clone_state(const void *data) {
+    SearchState *clone = malloc(sizeof(SearchState));
+    allocate_state(clone);
+    copy_state(clone, data);
+    return clone;
+}
+
+// Free the schedules of a search state
+void free_state(SearchState *state) {
+    free(state->current_schedule);
+    free(state->best_schedule);
+    free(state->mode);
+    free(state->best_mode);
+    free(state->position);
+    free(state->used);
+    free(state->start_time);
+    free(state->late_start);
+    free(state->ready);
+    free(state->list);
+    free(state->keys);
+    sa_profile_free(&state->profile);
+}
+
+// Free a cloned search state
+void destroy_state(void *data) {
+    free_state(data);
+    free(data);
+}
+
+// List the tasks in an order of precedence: each step takes a task whose
+// predecessors are all listed, the first such task in index order, or a
+// random one when rng is given
+void order_tasks(SearchState *state, sa_rng *rng) {
+    int *eligible = state->list, *pending = state->ready, count = 0;
     for (int i = 0; i < num_tasks; ++i) {
-        current_schedule[i] = i;
-    }
-    best_makespan = calculate_makespan(current_schedule);
-    memcpy(best_schedule, current_schedule, sizeof(current_schedule));
-
-    // Simulated annealing loop
-    while (temperature > MIN_TEMPERATURE) {
-        for (int i = 0; i < MAX_ITERATIONS; ++i) {
-            int neighbor_schedule[MAX_TASKS];
-            generate_neighbor(current_schedule, neighbor_schedule);
-            int neighbor_makespan = calculate_makespan(neighbor_schedule);
-            double prob = acceptance_probability(current_makespan, neighbor_makespan, temperature);
-            if (prob > (double) rand() / RAND_MAX) {
-                memcpy(current_schedule, neighbor_schedule, sizeof(neighbor_schedule));
-                current_makespan = neighbor_makespan;
-                if (current_makespan < best_makespan) {
-                    best_makespan = current_makespan;
-                    memcpy(best_schedule, current_schedule, sizeof(current_schedule));
-                }
+        pending[i] = predecessor_start[i + 1] - predecessor_start[i];
+        if (pending[i] == 0) {
+            eligible[count++] = i;
+        }
+    }
+    for (int i = 0; i < num_tasks; ++i) {
+        int pick = rng != NULL ? sa_rng_below(rng, count) : 0;
+        int task = eligible[pick];
+        memmove(&eligible[pick], &eligible[pick + 1], (--count - pick) * sizeof(int));
+        state->current_schedule[i] = task;
+        state->position[task] = i;
+        for (int j = project.successor_start[task]; j < project.successor_start[task + 1]; ++j) {
+            if (--pending[project.successors[j]] == 0) {
+                eligible[count++] = project.successors[j];
             }
         }
-        temperature *= COOLING_RATE;
     }
+}
 
-    // Print the best schedule found
-    printf("Best Schedule (Makespan: %d):\n", best_makespan);
-    print_schedule(best_schedule);
+// Start every task in the mode that uses the least of the nonrenewable
+// budgets (the shortest one on ties)
+void choose_modes(SearchState *state) {
+    memset(state->used, 0, sizeof(int) * num_nonrenewables);
+    for (int i = 0; i < num_tasks; ++i) {
+        int best = project.mode_start[i];
+        double least = INFINITY;
+        for (int m = project.mode_start[i]; m < project.mode_start[i + 1]; ++m) {
+            double share = 0.0;
+            for (int k = 0; k < num_nonrenewables; ++k) {
+                share += (double)project.consumption[m * num_nonrenewables + k] / (project.budget[k] + 1);
+            }
+            if (share < least || (share == least && project.duration[m] < project.duration[best])) {
+                best = m;
+                least = share;
+            }
+        }
+        state->mode[i] = best;
+        for (int k = 0; k < num_nonrenewables; ++k) {
+            state->used[k] += project.consumption[best * num_nonrenewables + k];
+        }
+    }
+    state->excess = 0;
+    for (int k = 0; k < num_nonrenewables; ++k) {
+        state->excess += state->used[k] > project.budget[k] ? state->used[k] - project.budget[k] : 0;
+    }
+}
+
+// Start a restarted chain from a random task order
+void restart_schedule(void *data, sa_rng *rng) {
+    order_tasks(data, rng);
+    choose_modes(data);
 }
 
-// Helper function to print the schedule
-void print_schedule(int schedule[]) {
+// Lower bound on the makespan, the larger of two: the longest path through
+// the precedence graph with every task in its shortest mode, and for each
+// renewable resource the least work it must do (duration times request, in
+// the cheapest mode of each task) spread over its whole capacity
+int lower_bound(int *critical_path, int *energy) {
+    int finish[num_tasks], pending[num_tasks], queue[num_tasks], head = 0, tail = 0;
+    *critical_path = 0;
     for (int i = 0; i < num_tasks; ++i) {
-        printf("Task %d ➜ Position %d\n", i, schedule[i]);
+        finish[i] = 0;
+        pending[i] = predecessor_start[i + 1] - predecessor_start[i];
+        if (pending[i] == 0) {
+            queue[tail++] = i;
+        }
+    }
+    while (head < tail) {
+        int task = queue[head++], shortest = project.duration[project.mode_start[task]];
+        for (int m = project.mode_start[task] + 1; m < project.mode_start[task + 1]; ++m) {
+            shortest = project.duration[m] < shortest ? project.duration[m] : shortest;
+        }
+        finish[task] += shortest;
+        *critical_path = finish[task] > *critical_path ? finish[task] : *critical_path;
+        for (int j = project.successor_start[task]; j < project.successor_start[task + 1]; ++j) {
+            int successor = project.successors[j];
+            finish[successor] = finish[task] > finish[successor] ? finish[task] : finish[successor];
+            if (--pending[successor] == 0) {
+                queue[tail++] = successor;
+            }
+        }
+    }
+    *energy = 0;
+    for (int r = 0; r < num_resources; ++r) {
+        long long work = 0;
+        for (int i = 0; i < num_tasks; ++i) {
+            long long least = -1;
+            for (int m = project.mode_start[i]; m < project.mode_start[i + 1]; ++m) {
+                long long need = (long long)project.duration[m] * project.request[m * num_resources + r];
+                least = least < 0 || need < least ? need : least;
+            }
+            work += least;
+        }
+        if (resource_avail[r] > 0) {
+            int bound = (int)((work + resource_avail[r] - 1) / resource_avail[r]);
+            *energy = bound > *energy ? bound : *energy;
+        }
+    }
+    return *critical_path > *energy ? *critical_path : *energy;
+}
+
+// Simulated annealing algorithm
+void simulated_annealing(const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    allocate_state(&state);
+    order_tasks(&state, NULL);
+    choose_modes(&state);
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMPERATURE,
+        .cooling_rate = COOLING_RATE,
+        .min_temperature = MIN_TEMPERATURE,
+        .iterations_per_temperature = MAX_ITERATIONS,
+    };
+    sa_problem problem = {
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_schedule,
+        .cost = schedule_cost,
+        .move_size = sizeof(Move),
+        .propose = propose_move,
+        .apply = apply_move,
+        .undo = undo_move,
+        .save_best = save_best_schedule,
+        .intensify = justify_schedule,
+    };
+    // No schedule beats the lower bound, so the chains stop once they reach it
+    int critical_path, energy;
+    int bound = lower_bound(&critical_path, &energy);
+    printf("Lower Bound: %d (critical path %d, resource energy %d)\n", bound, critical_path, energy);
+    sa_options run = *options;
+    run.target = run.target > bound ? run.target : bound;
+    int best_cost = (int)sa_solve(&problem, &state, &params, &run, rng, NULL);
+
+    // Print the best schedule found
+    memcpy(state.mode, state.best_mode, sizeof(int) * num_tasks);
+    int best_makespan = calculate_makespan(&state, state.best_schedule, INFINITY);
+    printf("Best Schedule (Makespan: %d):\n", best_makespan);
+    if (best_cost == bound) {
+        printf("Optimal: the makespan equals the lower bound\n");
+    } else {
+        printf("Gap to the lower bound: %.2f%%\n", bound > 0 ? 100.0 * (best_cost - bound) / bound : 0.0);
+    }
+    if (best_cost != best_makespan) {
+        printf("Nonrenewable resources over budget by %d units\n", (best_cost - best_makespan) / penalty);
+    }
+    for (int i = 0; i < num_tasks; ++i) {
+        printf("Task %d ➜ Start %d", i, state.start_time[i]);
+        if (num_multi_mode > 0) {
+            printf(", Mode %d", state.mode[i] - project.mode_start[i] + 1);
+        }
+        printf("\n");
+    }
+    for (int p = 0; p < project.projects && project.projects > 1; ++p) {
+        int end = 0;
+        for (int i = project.project_start[p]; i < project.project_start[p + 1]; ++i) {
+            int finish = state.start_time[i] + project.duration[state.mode[i]];
+            end = finish > end ? finish : end;
+        }
+        printf("Project %d ends at %d\n", p + 1, end);
     }
+    free_state(&state);
 }
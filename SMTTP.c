@@ -3,102 +3,230 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
-#define MAX_JOBS 20    // Maximum number of jobs
+#include "sa.h"
+#include "sa_instance.h"
 #define MAX_ITER 10000 // Maximum number of iterations for SA
 // Structure to represent a job
 typedef struct {
     int processing_time;
     int due_date;
 } Job;
-// Function to calculate total tardiness of a sequence of jobs
-int calculate_total_tardiness(Job *jobs, int *sequence, int num_jobs) {
-    int current_time = 0;
-    int total_tardiness = 0;
-    for (int i = 0; i < num_jobs; i++) {
-        int job_index = sequence[i];
-        current_time += jobs[job_index].processing_time;
-        int tardiness = fmax(0, current_time - jobs[job_index].due_date);
-        total_tardiness += tardiness;
-    }
-    return total_tardiness;
-}
 // Function to generate a random initial solution (random permutation of jobs)
-void generate_random_solution(int *sequence, int num_jobs) {
+void generate_random_solution(int *sequence, int num_jobs, sa_rng *rng) {
     for (int i = 0; i < num_jobs; i++) {
         sequence[i] = i;
     }
     for (int i = num_jobs - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
+        int j = sa_rng_below(rng, i + 1);
         int temp = sequence[i];
         sequence[i] = sequence[j];
         sequence[j] = temp;
     }
 }
-// Simulated Annealing function to minimize total tardiness
-void simulated_annealing(Job *jobs, int *best_sequence, int num_jobs) {
-    int current_sequence[MAX_JOBS];
-    int current_tardiness, best_tardiness;
-    double temperature = 100.0;
-    double cooling_rate = 0.99;
-    int iteration = 0;
-    // Generate a random initial solution
-generate_random_solution(current_sequence, num_jobs);
-    current_tardiness = calculate_total_tardiness(jobs, current_sequence, num_jobs);
-    best_tardiness = current_tardiness;
-    for (int i = 0; i < num_jobs; i++) {
-        best_sequence[i] = current_sequence[i];
+// Annealing state: instance, current sequence and best sequence, with the
+// completion time of the job at each position of the current sequence and
+// its total tardiness
+typedef struct {
+    Job *jobs;
+    int num_jobs;
+    int *current_sequence;
+    int *best_sequence;
+    int *completion;
+    int total_tardiness;
+} SearchState;
+// Move: swap the jobs at two positions
+typedef struct {
+    int pos1;
+    int pos2;
+} Move;
+// Tardiness of a job that completes at time completion
+static inline int tardiness(const Job *job, int completion) {
+    return completion > job->due_date ? completion - job->due_date : 0;
+}
+// Function to evaluate the current sequence, recording its completion times
+double sequence_cost(void *data, double limit) {
+    SearchState *state = data;
+    (void)limit;
+    int current_time = 0;
+    state->total_tardiness = 0;
+    for (int i = 0; i < state->num_jobs; i++) {
+        const Job *job = &state->jobs[state->current_sequence[i]];
+        current_time += job->processing_time;
+        state->completion[i] = current_time;
+        state->total_tardiness += tardiness(job, current_time);
     }
-    // Perform simulated annealing
-    while (temperature > 1.0 && iteration < MAX_ITER) {
-        int new_sequence[MAX_JOBS];
-        for (int i = 0; i < num_jobs; i++) {
-            new_sequence[i] = current_sequence[i];
-        }
-        // Perform a small change to get a new neighboring solution
-        int rand_pos1 = rand() % num_jobs;
-        int rand_pos2 = rand() % num_jobs;
-        int temp = new_sequence[rand_pos1];
-        new_sequence[rand_pos1] = new_sequence[rand_pos2];
-        new_sequence[rand_pos2] = temp;
-        // Calculate the tardiness of the new solution
-        int new_tardiness = calculate_total_tardiness(jobs, new_sequence, num_jobs);
-        // Decide whether to accept the new solution
-        if (new_tardiness < current_tardiness || exp(-(new_tardiness - current_tardiness) / temperature) > ((double)rand() / RAND_MAX)) {
-            for (int i = 0; i < num_jobs; i++) {
-current_sequence[i] = new_sequence[i];
-            }
-current_tardiness = new_tardiness;
-            // Update the best solution found so far
-            if (current_tardiness < best_tardiness) {
-                best_tardiness = current_tardiness;
-                for (int i = 0; i < num_jobs; i++) {
-                    best_sequence[i] = current_sequence[i];
-                }
-            }
+    return state->total_tardiness;
+}
+// Function to cost a swap from the completion times: the jobs before the
+// first position and from the second on end as before, those between move by
+// the difference of the two swapped jobs' processing times, so only the
+// range between the positions is visited (two jobs for adjacent positions).
+// The change can fall as well as rise along the range, so it is not cut short
+// at limit.
+double swap_cost(void *data, const void *move_data, double limit) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    (void)limit;
+    int first = move->pos1 < move->pos2 ? move->pos1 : move->pos2;
+    int last = move->pos1 < move->pos2 ? move->pos2 : move->pos1;
+    const int *sequence = state->current_sequence, *completion = state->completion;
+    const Job *early = &state->jobs[sequence[first]], *late = &state->jobs[sequence[last]];
+    int shift = late->processing_time - early->processing_time;
+    int delta = tardiness(late, completion[first] + shift) - tardiness(early, completion[first]) +
+                tardiness(early, completion[last]) - tardiness(late, completion[last]);
+    if (shift != 0) {
+        for (int i = first + 1; i < last; i++) {
+            const Job *job = &state->jobs[sequence[i]];
+            delta += tardiness(job, completion[i] + shift) - tardiness(job, completion[i]);
         }
-        // Cool the temperature
-        temperature *= cooling_rate;
-        iteration++;
     }
+    return state->total_tardiness + delta;
+}
+// Function to swap two positions, updating the completion times between them
+void swap_positions(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int first = move->pos1 < move->pos2 ? move->pos1 : move->pos2;
+    int last = move->pos1 < move->pos2 ? move->pos2 : move->pos1;
+    for (int i = first; i <= last; i++) {
+        state->total_tardiness -= tardiness(&state->jobs[state->current_sequence[i]], state->completion[i]);
+    }
+    int temp = state->current_sequence[move->pos1];
+    state->current_sequence[move->pos1] = state->current_sequence[move->pos2];
+    state->current_sequence[move->pos2] = temp;
+    int current_time = first > 0 ? state->completion[first - 1] : 0;
+    for (int i = first; i <= last; i++) {
+        const Job *job = &state->jobs[state->current_sequence[i]];
+        current_time += job->processing_time;
+        state->completion[i] = current_time;
+        state->total_tardiness += tardiness(job, current_time);
+    }
+}
+// Function to pick two different positions
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    if (state->num_jobs < 2) {
+        return 0;
+    }
+    move->pos1 = sa_rng_below(rng, state->num_jobs);
+    move->pos2 = sa_rng_below(rng, state->num_jobs);
+    while (move->pos1 == move->pos2) {
+        move->pos2 = sa_rng_below(rng, state->num_jobs);
+    }
+    return 1;
+}
+// Function to record the current sequence as the best one
+void save_best_sequence(void *data) {
+    SearchState *state = data;
+    for (int i = 0; i < state->num_jobs; i++) {
+        state->best_sequence[i] = state->current_sequence[i];
+    }
+}
+// Function to copy the sequences of one search state into another
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    for (int i = 0; i < from->num_jobs; i++) {
+        to->current_sequence[i] = from->current_sequence[i];
+        to->best_sequence[i] = from->best_sequence[i];
+        to->completion[i] = from->completion[i];
+    }
+    to->total_tardiness = from->total_tardiness;
+}
+// Function to copy a search state for a restarted chain
+void *clone_state(const void *data) {
+    const SearchState *state = data;
+    SearchState *clone = malloc(sizeof(SearchState));
+    *clone = *state;
+    clone->current_sequence = malloc(state->num_jobs * sizeof(int));
+    clone->best_sequence = malloc(state->num_jobs * sizeof(int));
+    clone->completion = malloc(state->num_jobs * sizeof(int));
+    copy_state(clone, state);
+    return clone;
+}
+// Function to free a cloned search state
+void destroy_state(void *data) {
+    SearchState *state = data;
+    free(state->current_sequence);
+    free(state->best_sequence);
+    free(state->completion);
+    free(state);
+}
+// Function to start a restarted chain from a new random permutation
+void restart_sequence(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    generate_random_solution(state->current_sequence, state->num_jobs, rng);
+}
+// Simulated Annealing function to minimize total tardiness
+void simulated_annealing(Job *jobs, int *best_sequence, int num_jobs, const sa_options *options, sa_rng *rng) {
+    SearchState state = {jobs, num_jobs, malloc(num_jobs * sizeof(int)), best_sequence, malloc(num_jobs * sizeof(int)), 0};
+    // Generate a random initial solution
+generate_random_solution(state.current_sequence, num_jobs, rng);
+    sa_params params = {
+        .initial_temperature = 100.0,
+        .cooling_rate = 0.99,
+        .min_temperature = 1.0,
+        .max_iterations = MAX_ITER,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_sequence,
+        .cost = sequence_cost,
+        .propose = propose_move,
+        .evaluate = swap_cost,
+        .apply = swap_positions,
+        .save_best = save_best_sequence,
+    };
+    int best_tardiness = (int)sa_solve(&problem, &state, &params, options, rng, NULL);
+    free(state.current_sequence);
+    free(state.completion);
     printf("Best sequence found:\n");
     for (int i = 0; i < num_jobs; i++) {
         printf("%d ", best_sequence[i]);
     }
     printf("\nTotal tardiness = %d\n", best_tardiness);
 }
-int main() {
-    srand(time(NULL));
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
     // Example data: processing times and due dates for jobs
-    Job jobs[MAX_JOBS] = {
+    Job example_jobs[] = {
         {3, 10},
         {5, 15},
         {2, 7},
         {7, 20},
         {4, 11}
     };
+    Job *jobs = example_jobs;
     int num_jobs = 5;
-    int best_sequence[MAX_JOBS];
+    if (options.instance != NULL) {
+        // OR-Library wt40/wt50/wt100 instance; the weights are ignored
+        sa_single_machine instance;
+        if (sa_load_single_machine(options.instance, options.format, options.index, &instance) != 0) {
+            return 1;
+        }
+        num_jobs = instance.jobs;
+        jobs = malloc(num_jobs * sizeof(Job));
+        for (int i = 0; i < num_jobs; i++) {
+            jobs[i] = (Job){instance.p[i], instance.d[i]};
+        }
+        sa_free_single_machine(&instance);
+    }
+    int *best_sequence = malloc(num_jobs * sizeof(int));
     // Solve the problem using simulated annealing
-    simulated_annealing(jobs, best_sequence, num_jobs);
+    simulated_annealing(jobs, best_sequence, num_jobs, &options, &rng);
+    free(best_sequence);
+    if (jobs != example_jobs) {
+        free(jobs);
+    }
     return 0;
 }
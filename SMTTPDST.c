@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
 #define MAX_JOBS 20   // Maximum number of jobs
 #define MAX_ITER 1000 // Maximum number of iterations
 #define INITIAL_TEMP 100.0
@@ -15,26 +16,30 @@ typedef struct {
 } Job;
 
 // Function prototypes
-void generate_random_instance(Job jobs[], int n);
-int calculate_total_tardiness(Job jobs[], int n, int sequence[]);
-int evaluate_solution(Job jobs[], int n, int sequence[]);
+void generate_random_instance(Job jobs[], int n, sa_rng *rng);
+int calculate_total_tardiness(Job jobs[], int n, int sequence[], double limit);
 void copy_sequence(int dest[], int src[], int n);
-void simulated_annealing(Job jobs[], int n, int best_sequence[]);
+void simulated_annealing(Job jobs[], int n, int best_sequence[], const sa_options *options, sa_rng *rng);
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
     int n = 10; // Number of jobs (example: 10 jobs)
     Job jobs[MAX_JOBS];
 
     // Generate random instance of jobs
-    generate_random_instance(jobs, n);
+    generate_random_instance(jobs, n, &rng);
 
     // Array to store the best sequence found
     int best_sequence[MAX_JOBS];
 
     // Solve using simulated annealing
-    simulated_annealing(jobs, n, best_sequence);
+    simulated_annealing(jobs, n, best_sequence, &options, &rng);
 
     // Output the best sequence found
     printf("\nBest job sequence:\n");
@@ -44,22 +49,23 @@ int main() {
     printf("\n");
 
     // Calculate and print the total tardiness of the best sequence found
-    int total_tardiness = calculate_total_tardiness(jobs, n, best_sequence);
+    int total_tardiness = calculate_total_tardiness(jobs, n, best_sequence, INFINITY);
     printf("Total tardiness =  %d\n", total_tardiness);
 
     return 0;
 }
 
 // Function to generate a random instance of jobs
-void generate_random_instance(Job jobs[], int n) {
+void generate_random_instance(Job jobs[], int n, sa_rng *rng) {
     for (int i = 0; i < n; i++) {
-        jobs[i].processing_time = rand() % 20 + 1; // Random processing time between 1 and 20
-        jobs[i].due_date = rand() % 50 + 1;       // Random due date between 1 and 50
+        jobs[i].processing_time = sa_rng_below(rng, 20) + 1; // Random processing time between 1 and 20
+        jobs[i].due_date = sa_rng_below(rng, 50) + 1;       // Random due date between 1 and 50
     }
 }
 
 // Function to calculate the total tardiness of a sequence of jobs
-int calculate_total_tardiness(Job jobs[], int n, int sequence[]) {
+// The running total never decreases, so stop once it exceeds limit
+int calculate_total_tardiness(Job jobs[], int n, int sequence[], double limit) {
     int completion_time = 0;
     int total_tardiness = 0;
 
@@ -68,16 +74,14 @@ int calculate_total_tardiness(Job jobs[], int n, int sequence[]) {
         completion_time += jobs[job_index].processing_time;
         int tardiness = fmax(completion_time - jobs[job_index].due_date, 0);
         total_tardiness += tardiness;
+        if (total_tardiness > limit) {
+            break;
+        }
     }
 
     return total_tardiness;
 }
 
-// Function to evaluate the solution (negative of total tardiness for minimization)
-int evaluate_solution(Job jobs[], int n, int sequence[]) {
-    return -calculate_total_tardiness(jobs, n, sequence);
-}
-
 // Function to copy one sequence to another
 void copy_sequence(int dest[], int src[], int n) {
     for (int i = 0; i < n; i++) {
@@ -85,65 +89,98 @@ void copy_sequence(int dest[], int src[], int n) {
     }
 }
 
-// Function to perform simulated annealing
-void simulated_annealing(Job jobs[], int n, int best_sequence[]) {
+// Annealing state: instance, current sequence and best sequence
+typedef struct {
+    Job *jobs;
+    int n;
     int current_sequence[MAX_JOBS];
-    int current_total_tardiness, best_total_tardiness;
-    int new_sequence[MAX_JOBS];
-    int new_total_tardiness;
-    double temperature = INITIAL_TEMP;
+    int best_sequence[MAX_JOBS];
+} SearchState;
 
-    // Initialize the current sequence randomly
+// Move: swap the jobs at two positions
+typedef struct {
+    int index1;
+    int index2;
+} Move;
+
+// Function to evaluate the current sequence
+double sequence_cost(void *data, double limit) {
+    SearchState *state = data;
+    return calculate_total_tardiness(state->jobs, state->n, state->current_sequence, limit);
+}
+
+// Function to pick two different positions to swap
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    move->index1 = sa_rng_below(rng, state->n);
+    move->index2 = sa_rng_below(rng, state->n);
+    while (move->index1 == move->index2) {
+        move->index2 = sa_rng_below(rng, state->n);
+    }
+    return 1;
+}
+
+// Function to swap two positions (a swap is its own undo)
+void swap_jobs(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int temp = state->current_sequence[move->index1];
+    state->current_sequence[move->index1] = state->current_sequence[move->index2];
+    state->current_sequence[move->index2] = temp;
+}
+
+// Function to record the current sequence as the best one
+void save_best_sequence(void *data) {
+    SearchState *state = data;
+    copy_sequence(state->best_sequence, state->current_sequence, state->n);
+}
+
+// Function to build a random sequence of n jobs
+void random_sequence(int sequence[], int n, sa_rng *rng) {
     for (int i = 0; i < n; i++) {
-        current_sequence[i] = i;
+        sequence[i] = i;
     }
-    // Randomly shuffle the initial sequence
+    // Randomly shuffle the sequence
     for (int i = 0; i < n - 1; i++) {
-        int j = i + rand() % (n - i);
+        int j = i + sa_rng_below(rng, n - i);
         if (i != j) {
-            int temp = current_sequence[i];
-            current_sequence[i] = current_sequence[j];
-            current_sequence[j] = temp;
+            int temp = sequence[i];
+            sequence[i] = sequence[j];
+            sequence[j] = temp;
         }
     }
+}
 
-    // Evaluate the initial solution
-    current_total_tardiness = evaluate_solution(jobs, n, current_sequence);
-    copy_sequence(best_sequence, current_sequence, n);
-    best_total_tardiness = current_total_tardiness;
-
-    // Simulated annealing main loop
-    int iteration = 0;
-    while (iteration < MAX_ITER && temperature > 0.1) {
-        // Generate a new neighbor solution by swapping two jobs in the current sequence
-        copy_sequence(new_sequence, current_sequence, n);
-        int index1 = rand() % n;
-        int index2 = rand() % n;
-        while (index1 == index2) {
-            index2 = rand() % n;
-        }
-        int temp = new_sequence[index1];
-        new_sequence[index1] = new_sequence[index2];
-        new_sequence[index2] = temp;
-
-        // Evaluate the new solution
-        new_total_tardiness = evaluate_solution(jobs, n, new_sequence);
-
-        // Accept the new solution if it's better or according to the acceptance probability
-        if (new_total_tardiness < current_total_tardiness ||
-            exp((new_total_tardiness - current_total_tardiness) / temperature) > (rand() / (double)RAND_MAX)) {
-            copy_sequence(current_sequence, new_sequence, n);
-            current_total_tardiness = new_total_tardiness;
-
-            // Update the best solution found so far
-            if (current_total_tardiness < best_total_tardiness) {
-                copy_sequence(best_sequence, current_sequence, n);
-                best_total_tardiness = current_total_tardiness;
-            }
-        }
+// Function to start a restarted chain from a new random sequence
+void restart_sequence(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    random_sequence(state->current_sequence, state->n, rng);
+}
 
-        // Decrease the temperature
-        temperature *= COOLING_RATE;
-        iteration++;
-    }
+// Function to perform simulated annealing
+void simulated_annealing(Job jobs[], int n, int best_sequence[], const sa_options *options, sa_rng *rng) {
+    SearchState state = {jobs, n, {0}, {0}};
+
+    // Initialize the current sequence randomly
+    random_sequence(state.current_sequence, n, rng);
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMP,
+        .cooling_rate = COOLING_RATE,
+        .min_temperature = 0.1,
+        .max_iterations = MAX_ITER,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .state_size = sizeof(SearchState),
+        .restart = restart_sequence,
+        .cost = sequence_cost,
+        .propose = propose_move,
+        .apply = swap_jobs,
+        .undo = swap_jobs,
+        .save_best = save_best_sequence,
+    };
+    sa_solve(&problem, &state, &params, options, rng, NULL);
+    copy_sequence(best_sequence, state.best_sequence, n);
 }
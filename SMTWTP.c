@@ -4,7 +4,8 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
-#define MAX_JOBS 10 // Maximum number of jobs
+#include "sa.h"
+#include "sa_instance.h"
 #define MAX_ITER 10000 // Maximum number of iterations for SA
 #define INITIAL_TEMP 100.0 // Initial temperature
 #define COOLING_RATE 0.95 // Cooling rate
@@ -13,28 +14,49 @@
 typedef struct {
     int processing_time;
     int weight;
+    int due_date;
 } Job;
 
 // Function prototypes
 void initialize_jobs(Job jobs[], int n);
-int calculate_total_tardiness(Job jobs[], int n, int order[]);
+int calculate_total_tardiness(Job jobs[], int n, int order[], double limit);
 void swap(int *a, int *b);
-double acceptance_probability(int current_tardiness, int new_tardiness, double temperature);
-void simulated_annealing(Job jobs[], int n, int order[]);
+void simulated_annealing(Job jobs[], int n, int order[], const sa_options *options, sa_rng *rng);
+
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
 
-int main() {
     int n = 5; // Number of jobs
-    Job jobs[MAX_JOBS] = {
-        {3, 4}, // processing_time = 3, weight = 4
-        {7, 2}, // processing_time = 7, weight = 2
-        {2, 5}, // processing_time = 2, weight = 5
-        {5, 7}, // processing_time = 5, weight = 7
-        {4, 3}  // processing_time = 4, weight = 3
+    Job example_jobs[] = {
+        {3, 4, 6},  // processing_time = 3, weight = 4, due_date = 6
+        {7, 2, 14}, // processing_time = 7, weight = 2, due_date = 14
+        {2, 5, 4},  // processing_time = 2, weight = 5, due_date = 4
+        {5, 7, 12}, // processing_time = 5, weight = 7, due_date = 12
+        {4, 3, 9}   // processing_time = 4, weight = 3, due_date = 9
     };
-    int order[MAX_JOBS]; // Order of jobs (solution)
+    Job *jobs = example_jobs;
+    if (options.instance != NULL) {
+        // OR-Library wt40/wt50/wt100 instance
+        sa_single_machine instance;
+        if (sa_load_single_machine(options.instance, options.format, options.index, &instance) != 0) {
+            return 1;
+        }
+        n = instance.jobs;
+        jobs = malloc(n * sizeof(Job));
+        for (int i = 0; i < n; i++) {
+            jobs[i] = (Job){instance.p[i], instance.w[i], instance.d[i]};
+        }
+        sa_free_single_machine(&instance);
+    }
+    int *order = malloc(n * sizeof(int)); // Order of jobs (solution)
 
     // Solve using simulated annealing
-    simulated_annealing(jobs, n, order);
+    simulated_annealing(jobs, n, order, &options, &rng);
 
     // Output the optimal order found
     printf("Optimal order of jobs to minimize total weighted tardiness:\n");
@@ -44,21 +66,29 @@ int main() {
     printf("\n");
 
     // Calculate and print the total weighted tardiness of the optimal order
-    int total_tardiness = calculate_total_tardiness(jobs, n, order);
+    int total_tardiness = calculate_total_tardiness(jobs, n, order, INFINITY);
     printf("Total weighted tardiness: %d\n", total_tardiness);
 
+    free(order);
+    if (jobs != example_jobs) {
+        free(jobs);
+    }
     return 0;
 }
 
 // Function to calculate the total weighted tardiness for a given order of jobs
-int calculate_total_tardiness(Job jobs[], int n, int order[]) {
+// The running total never decreases, so stop once it exceeds limit
+int calculate_total_tardiness(Job jobs[], int n, int order[], double limit) {
     int current_time = 0;
     int total_tardiness = 0;
     for (int i = 0; i < n; i++) {
         int job_index = order[i];
         current_time += jobs[job_index].processing_time;
-        int tardiness = fmax(0, current_time - jobs[job_index].weight);
-        total_tardiness += tardiness;
+        int tardiness = fmax(0, current_time - jobs[job_index].due_date);
+        total_tardiness += jobs[job_index].weight * tardiness;
+        if (total_tardiness > limit) {
+            break;
+        }
     }
     return total_tardiness;
 }
@@ -70,67 +100,123 @@ void swap(int *a, int *b) {
     *b = temp;
 }
 
-// Function to calculate acceptance probability in simulated annealing
-double acceptance_probability(int current_tardiness, int new_tardiness, double temperature) {
-    if (new_tardiness < current_tardiness) {
-        return 1.0; // Accept the new solution if it's better
-    }
-    return exp((current_tardiness - new_tardiness) / temperature);
+// Annealing state: instance, current order and best order
+typedef struct {
+    Job *jobs;
+    int n;
+    int *current_order;
+    int *best_order;
+} SearchState;
+
+// Move: swap the jobs at two positions
+typedef struct {
+    int i;
+    int j;
+} Move;
+
+// Function to evaluate the current order
+double order_cost(void *data, double limit) {
+    SearchState *state = data;
+    return calculate_total_tardiness(state->jobs, state->n, state->current_order, limit);
 }
 
-// Function implementing simulated annealing to solve the problem
-void simulated_annealing(Job jobs[], int n, int order[]) {
-    int current_order[MAX_JOBS]; // Current order of jobs
-    int best_order[MAX_JOBS]; // Best order found so far
-    int current_tardiness, best_tardiness;
-    double temperature = INITIAL_TEMP;
+// Function to pick two random positions
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    move->i = sa_rng_below(rng, state->n);
+    move->j = sa_rng_below(rng, state->n);
+    return 1;
+}
 
-    // Initialize the current order randomly
-    for (int i = 0; i < n; i++) {
-        current_order[i] = i;
+// Function to swap two positions (a swap is its own undo)
+void swap_move(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    swap(&state->current_order[move->i], &state->current_order[move->j]);
+}
+
+// Function to record the current order as the best one
+void save_best_order(void *data) {
+    SearchState *state = data;
+    for (int k = 0; k < state->n; k++) {
+        state->best_order[k] = state->current_order[k];
     }
+}
 
-    // Initialize best order as current order
-    for (int i = 0; i < n; i++) {
-        best_order[i] = current_order[i];
+// Function to copy the orders of one search state into another
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    for (int k = 0; k < from->n; k++) {
+        to->current_order[k] = from->current_order[k];
+        to->best_order[k] = from->best_order[k];
     }
+}
 
-    // Calculate initial total tardiness
-    current_tardiness = calculate_total_tardiness(jobs, n, current_order);
-    best_tardiness = current_tardiness;
-
-    // Simulated annealing loop
-    for (int iter = 0; iter < MAX_ITER; iter++) {
-        // Generate new solution by swapping two jobs
-        int i = rand() % n;
-        int j = rand() % n;
-        swap(&current_order[i], &current_order[j]);
-
-        // Calculate new total tardiness
-        int new_tardiness = calculate_total_tardiness(jobs, n, current_order);
-
-        // Decide whether to accept the new solution
-        if (acceptance_probability(current_tardiness, new_tardiness, temperature) > (double)rand() / RAND_MAX) {
-            // Accept the new solution
-            current_tardiness = new_tardiness;
-            // Update best solution found so far
-            if (current_tardiness < best_tardiness) {
-                best_tardiness = current_tardiness;
-                for (int k = 0; k < n; k++) {
-                    best_order[k] = current_order[k];
-                }
-            }
-        } else {
-            // Revert to the previous solution
-            swap(&current_order[i], &current_order[j]);
-        }
+// Function to copy a search state for a restarted chain
+void *clone_state(const void *data) {
+    const SearchState *state = data;
+    SearchState *clone = malloc(sizeof(SearchState));
+    *clone = *state;
+    clone->current_order = malloc(state->n * sizeof(int));
+    clone->best_order = malloc(state->n * sizeof(int));
+    copy_state(clone, state);
+    return clone;
+}
+
+// Function to free a cloned search state
+void destroy_state(void *data) {
+    SearchState *state = data;
+    free(state->current_order);
+    free(state->best_order);
+    free(state);
+}
 
-        // Cool down the temperature
-        temperature *= COOLING_RATE;
+// Function to start a restarted chain from a random order
+void restart_order(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    for (int i = state->n - 1; i > 0; i--) {
+        swap(&state->current_order[i], &state->current_order[sa_rng_below(rng, i + 1)]);
     }
+}
+
+// Function implementing simulated annealing to solve the problem
+void simulated_annealing(Job jobs[], int n, int order[], const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    state.jobs = jobs;
+    state.n = n;
+    state.current_order = malloc(n * sizeof(int));
+    state.best_order = malloc(n * sizeof(int));
+
+    // Initialize the current order
+    for (int i = 0; i < n; i++) {
+        state.current_order[i] = i;
+    }
+
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMP,
+        .cooling_rate = COOLING_RATE,
+        .max_iterations = MAX_ITER,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_order,
+        .cost = order_cost,
+        .propose = propose_move,
+        .apply = swap_move,
+        .undo = swap_move,
+        .save_best = save_best_order,
+    };
+    sa_solve(&problem, &state, &params, options, rng, NULL);
 
     // Set the best order found
     for (int i = 0; i < n; i++) {
-        order[i] = best_order[i];
+        order[i] = state.best_order[i];
     }
+    free(state.current_order);
+    free(state.best_order);
 }
@@ -3,85 +3,216 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
+#include "sa_instance.h"
 #define MAX_ITER 10000
 #define COOLING_FACTOR 0.95
 #define INITIAL_TEMP 100.0
 #define EPSILON 1e-5
-#define N 5  // Number of elements in the sequence
-// Objective function: Sum of pairwise squared differences
-double objective_function(int *sequence, int n) {
-    double sum = 0.0;
-    for (int i = 1; i < n; ++i) {
-        sum += pow(sequence[i] - sequence[i - 1], 2);
+#define N 5  // Number of elements in the built-in example
+// Problem instance: cost of each transition; -1 marks a precedence constraint
+sa_sequencing instance;
+// Predecessors of each element, as lists: element i has to come after
+// predecessors[predecessor_start[i] .. predecessor_start[i + 1] - 1]
+int *predecessor_start;
+int *predecessors;
+double violation_penalty; // Exceeds the cost of any sequence
+// Built-in example: moving from value a to value b costs (b - a)^2, so the
+// objective is the sum of pairwise squared differences of the values 1..N
+void build_example() {
+    instance.n = N;
+    instance.cost = malloc(N * N * sizeof(int));
+    for (int a = 0; a < N; ++a) {
+        for (int b = 0; b < N; ++b) {
+            instance.cost[a * N + b] = (b - a) * (b - a);
+        }
     }
-    return sum;
 }
-// Simulated annealing algorithm
-void simulated_annealing(int *sequence, int n) {
-    double current_energy, new_energy, temperature, acceptance_prob;
-    int temp_sequence[n];
-    int current_sequence[n];
-    int best_sequence[n];
-    double best_energy = INFINITY;
-    // Initialize current sequence randomly
+// Collect the precedence constraints and the penalty for breaking one
+void build_precedences() {
+    int n = instance.n;
+    predecessor_start = malloc((n + 1) * sizeof(int));
+    int count = 0;
     for (int i = 0; i < n; ++i) {
-        sequence[i] = i + 1;
-    }
-    // Use current time as seed for random generator
-    srand(time(NULL));
-    // Start with initial temperature
-    temperature = INITIAL_TEMP;
-    // Main loop of simulated annealing
-    for (int iter = 0; iter < MAX_ITER && temperature > EPSILON; ++iter) {
-        // Copy current sequence to temp_sequence
-        for (int i = 0; i < n; ++i) {
-            temp_sequence[i] = sequence[i];
+        for (int j = 0; j < n; ++j) {
+            count += i != j && instance.cost[i * n + j] == -1;
         }
-        // Perform a random swap of two elements
-        int index1 = rand() % n;
-        int index2 = rand() % n;
-        int temp = temp_sequence[index1];
-        temp_sequence[index1] = temp_sequence[index2];
-        temp_sequence[index2] = temp;
-        // Calculate energies
-        current_energy = objective_function(sequence, n);
-        new_energy = objective_function(temp_sequence, n);
-        // Decide whether to accept the new sequence
-        if (new_energy < current_energy) {
-            for (int i = 0; i < n; ++i) {
-                sequence[i] = temp_sequence[i];
+    }
+    predecessors = malloc((count + 1) * sizeof(int));
+    count = 0;
+    violation_penalty = 1.0;
+    for (int i = 0; i < n; ++i) {
+        predecessor_start[i] = count;
+        int max_cost = 0;
+        for (int j = 0; j < n; ++j) {
+            int cost = instance.cost[i * n + j];
+            if (i != j && cost == -1) {
+                predecessors[count++] = j;
             }
-            current_energy = new_energy;
-        } else {
-            acceptance_prob = exp(-(new_energy - current_energy) / temperature);
-            double random_value = (double)rand() / RAND_MAX;
-            if (random_value < acceptance_prob) {
-                for (int i = 0; i < n; ++i) {
-                    sequence[i] = temp_sequence[i];
-                }
-                current_energy = new_energy;
+            if (cost > max_cost) {
+                max_cost = cost;
             }
         }
-        // Update the best sequence found so far
-        if (current_energy < best_energy) {
-            best_energy = current_energy;
-            for (int i = 0; i < n; ++i) {
-                best_sequence[i] = sequence[i];
+        violation_penalty += max_cost;
+    }
+    predecessor_start[n] = count;
+}
+// Objective function: cost of the transitions plus a penalty per broken precedence
+// Both parts only grow, so stop once the total exceeds limit
+double objective_function(int *sequence, int n, double limit) {
+    double sum = 0.0;
+    int position[n];
+    for (int i = 0; i < n; ++i) {
+        position[sequence[i]] = i;
+    }
+    for (int i = 1; i < n; ++i) {
+        int cost = instance.cost[sequence[i - 1] * n + sequence[i]];
+        sum += cost >= 0 ? cost : violation_penalty;
+    }
+    for (int i = 0; i < n && sum <= limit; ++i) {
+        for (int k = predecessor_start[i]; k < predecessor_start[i + 1]; ++k) {
+            if (position[predecessors[k]] > position[i]) {
+                sum += violation_penalty;
             }
         }
-        // Cool the temperature
-        temperature *= COOLING_FACTOR;
     }
-    // Print the best sequence found
+    return sum;
+}
+// Annealing state: sequence being improved and best sequence seen
+typedef struct {
+    int *sequence;
+    int n;
+    int *best_sequence;
+} SearchState;
+// Move: swap the elements at two positions
+typedef struct {
+    int index1;
+    int index2;
+} Move;
+// Evaluate the current sequence
+double sequence_energy(void *data, double limit) {
+    SearchState *state = data;
+    return objective_function(state->sequence, state->n, limit);
+}
+// Pick two random positions
+int propose_move(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    move->index1 = sa_rng_below(rng, state->n);
+    move->index2 = sa_rng_below(rng, state->n);
+    return 1;
+}
+// Swap two positions (a swap is its own undo)
+void swap_elements(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    int temp = state->sequence[move->index1];
+    state->sequence[move->index1] = state->sequence[move->index2];
+    state->sequence[move->index2] = temp;
+}
+// Record the current sequence as the best one
+void save_best_sequence(void *data) {
+    SearchState *state = data;
+    for (int i = 0; i < state->n; ++i) {
+        state->best_sequence[i] = state->sequence[i];
+    }
+}
+// Copy the sequences of one search state into another
+void copy_state(void *dest, const void *src) {
+    SearchState *to = dest;
+    const SearchState *from = src;
+    for (int i = 0; i < from->n; ++i) {
+        to->sequence[i] = from->sequence[i];
+        to->best_sequence[i] = from->best_sequence[i];
+    }
+}
+// Copy a search state for a restarted chain
+void *clone_state(const void *data) {
+    const SearchState *state = data;
+    SearchState *clone = malloc(sizeof(SearchState));
+    clone->n = state->n;
+    clone->sequence = malloc(state->n * sizeof(int));
+    clone->best_sequence = malloc(state->n * sizeof(int));
+    copy_state(clone, state);
+    return clone;
+}
+// Free a cloned search state
+void destroy_state(void *data) {
+    SearchState *state = data;
+    free(state->sequence);
+    free(state->best_sequence);
+    free(state);
+}
+// Start a restarted chain from a random permutation
+void restart_sequence(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    for (int i = state->n - 1; i > 0; --i) {
+        int j = sa_rng_below(rng, i + 1);
+        int temp = state->sequence[i];
+        state->sequence[i] = state->sequence[j];
+        state->sequence[j] = temp;
+    }
+}
+// Simulated annealing algorithm
+void simulated_annealing(int *sequence, int n, const sa_options *options, sa_rng *rng) {
+    SearchState state;
+    state.n = n;
+    state.sequence = sequence;
+    state.best_sequence = malloc(n * sizeof(int));
+    // Initialize current sequence
+    for (int i = 0; i < n; ++i) {
+        sequence[i] = i;
+    }
+    sa_params params = {
+        .initial_temperature = INITIAL_TEMP,
+        .cooling_rate = COOLING_FACTOR,
+        .min_temperature = EPSILON,
+        .max_iterations = MAX_ITER,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .clone = clone_state,
+        .copy = copy_state,
+        .destroy = destroy_state,
+        .restart = restart_sequence,
+        .cost = sequence_energy,
+        .propose = propose_move,
+        .apply = swap_elements,
+        .undo = swap_elements,
+        .save_best = save_best_sequence,
+    };
+    double best_energy = sa_solve(&problem, &state, &params, options, rng, NULL);
+    // Print the best sequence found (elements numbered from 1)
     printf("Best sequence found: ");
     for (int i = 0; i < n; ++i) {
-        printf("%d ", best_sequence[i]);
+        sequence[i] = state.best_sequence[i];
+        printf("%d ", sequence[i] + 1);
     }
     printf("\n");
     printf("Objective function = %lf\n", best_energy);
+    free(state.best_sequence);
 }
-int main() {
-    int sequence[N];
-simulated_annealing(sequence, N);
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
+    if (options.instance != NULL) {
+        if (sa_load_sequencing(options.instance, options.format, options.index, &instance) != 0) {
+            return 1;
+        }
+    } else {
+        build_example();
+    }
+    build_precedences();
+    int *sequence = malloc(instance.n * sizeof(int));
+simulated_annealing(sequence, instance.n, &options, &rng);
+    free(sequence);
+    free(predecessors);
+    free(predecessor_start);
+    sa_free_sequencing(&instance);
     return 0;
 }
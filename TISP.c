@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include "sa.h"
 #define NUM_ACTIVITIES 5
 #define TIME_HORIZON 24 // Assuming a 24-hour time horizon
 
@@ -12,57 +13,71 @@ typedef struct {
     int end_time;
 } Activity;
 
+// Annealing state: current solution and best solution
+typedef struct {
+    Activity current_solution[NUM_ACTIVITIES];
+    Activity best_solution[NUM_ACTIVITIES];
+} SearchState;
+
+// Move: give one activity new times (the old ones are kept for undo)
+typedef struct {
+    int index;
+    Activity previous;
+    Activity replacement;
+} Move;
+
 // Function prototypes
-void initialize_solution(Activity solution[]);
+void initialize_solution(Activity solution[], sa_rng *rng);
 double evaluate_solution(Activity solution[]);
-void generate_neighbor(Activity solution[], Activity neighbor[]);
 void copy_solution(Activity source[], Activity destination[]);
 void print_solution(Activity solution[]);
-double acceptance_probability(double current_cost, double new_cost, double temperature);
-
-int main() {
-    srand(time(NULL)); // Initialize random seed
-
-    Activity current_solution[NUM_ACTIVITIES];
-    Activity neighbor_solution[NUM_ACTIVITIES];
-
-    double current_cost, new_cost;
-    double temperature = 1000.0; // Initial temperature
-    double cooling_rate = 0.95; // Cooling rate
-
-    initialize_solution(current_solution);
-    current_cost = evaluate_solution(current_solution);
-
-    while (temperature > 1.0) {
-        generate_neighbor(current_solution, neighbor_solution);
-        new_cost = evaluate_solution(neighbor_solution);
-
-        if (new_cost < current_cost) {
-            copy_solution(neighbor_solution, current_solution);
-            current_cost = new_cost;
-        } else {
-            double probability = acceptance_probability(current_cost, new_cost, temperature);
-            if (rand() / (double)RAND_MAX < probability) {
-                copy_solution(neighbor_solution, current_solution);
-                current_cost = new_cost;
-            }
-        }
-
-        temperature *= cooling_rate;
+double current_cost(void *state, double limit);
+int propose_neighbor(void *state, sa_rng *rng, void *move);
+void apply_move(void *state, const void *move);
+void undo_move(void *state, const void *move);
+void save_best_solution(void *state);
+void restart_solution(void *state, sa_rng *rng);
+
+int main(int argc, char **argv) {
+    sa_options options;
+    if (sa_parse_options(argc, argv, &options) != 0) {
+        return 1;
     }
+    sa_rng rng;
+    sa_rng_seed(&rng, options.seed);
+
+    SearchState state;
+    initialize_solution(state.current_solution, &rng);
+
+    sa_params params = {
+        .initial_temperature = 1000.0, // Initial temperature
+        .cooling_rate = 0.95, // Cooling rate
+        .min_temperature = 1.0,
+    };
+    sa_problem problem = {
+        .move_size = sizeof(Move),
+        .state_size = sizeof(SearchState),
+        .restart = restart_solution,
+        .cost = current_cost,
+        .propose = propose_neighbor,
+        .apply = apply_move,
+        .undo = undo_move,
+        .save_best = save_best_solution,
+    };
+    double best_cost = sa_solve(&problem, &state, &params, &options, &rng, NULL);
 
     printf("Solution:\n");
-    print_solution(current_solution);
-    printf("Cost = %.2f\n", current_cost);
+    print_solution(state.best_solution);
+    printf("Cost = %.2f\n", best_cost);
 
     return 0;
 }
 
 // Initialize the solution with random start and end times
-void initialize_solution(Activity solution[]) {
+void initialize_solution(Activity solution[], sa_rng *rng) {
     for (int i = 0; i < NUM_ACTIVITIES; i++) {
-        solution[i].start_time = rand() % (TIME_HORIZON + 1);
-        solution[i].end_time = solution[i].start_time + (rand() % (TIME_HORIZON - solution[i].start_time + 1));
+        solution[i].start_time = sa_rng_below(rng, TIME_HORIZON + 1);
+        solution[i].end_time = solution[i].start_time + (sa_rng_below(rng, TIME_HORIZON - solution[i].start_time + 1));
     }
 }
 
@@ -76,15 +91,6 @@ double evaluate_solution(Activity solution[]) {
     return cost;
 }
 
-// Generate a neighboring solution
-void generate_neighbor(Activity solution[], Activity neighbor[]) {
-    copy_solution(solution, neighbor);
-    // Perturb the neighbor solution (e.g., swap start and end times of a random activity)
-    int index = rand() % NUM_ACTIVITIES;
-    neighbor[index].start_time = rand() % (TIME_HORIZON + 1);
-    neighbor[index].end_time = neighbor[index].start_time + (rand() % (TIME_HORIZON - neighbor[index].start_time + 1));
-}
-
 // Copy one solution to another
 void copy_solution(Activity source[], Activity destination[]) {
     for (int i = 0; i < NUM_ACTIVITIES; i++) {
@@ -100,10 +106,46 @@ void print_solution(Activity solution[]) {
     }
 }
 
-// Calculate acceptance probability for simulated annealing
-double acceptance_probability(double current_cost, double new_cost, double temperature) {
-    if (new_cost < current_cost) {
-        return 1.0;
-    }
-    return exp((current_cost - new_cost) / temperature);
+// Evaluate the current solution
+double current_cost(void *data, double limit) {
+    (void)limit;
+    SearchState *state = data;
+    return evaluate_solution(state->current_solution);
+}
+
+// Pick new random start and end times for a random activity
+int propose_neighbor(void *data, sa_rng *rng, void *move_data) {
+    SearchState *state = data;
+    Move *move = move_data;
+    move->index = sa_rng_below(rng, NUM_ACTIVITIES);
+    move->previous = state->current_solution[move->index];
+    move->replacement.start_time = sa_rng_below(rng, TIME_HORIZON + 1);
+    move->replacement.end_time = move->replacement.start_time + (sa_rng_below(rng, TIME_HORIZON - move->replacement.start_time + 1));
+    return 1;
+}
+
+// Give the activity its new times
+void apply_move(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    state->current_solution[move->index] = move->replacement;
+}
+
+// Restore the activity's old times
+void undo_move(void *data, const void *move_data) {
+    SearchState *state = data;
+    const Move *move = move_data;
+    state->current_solution[move->index] = move->previous;
+}
+
+// Record the current solution as the best one
+void save_best_solution(void *data) {
+    SearchState *state = data;
+    copy_solution(state->current_solution, state->best_solution);
+}
+
+// Start a restarted chain from a new random solution
+void restart_solution(void *data, sa_rng *rng) {
+    SearchState *state = data;
+    initialize_solution(state->current_solution, rng);
 }
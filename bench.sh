@@ -0,0 +1,301 @@
+#!/bin/sh
+# Benchmark every solver on a fixed set of instances and seeds.
+# Each run appends one record (evaluations and accepted moves per second,
+# time to target, final costs, evaluator throughput) to $REPORT; use a
+# .json or .jsonl name for JSON lines instead of CSV.
+set -e
+
+BUILD=${BUILD:-build}
+SOLVERS=${SOLVERS:-"ASP CSP FJSP GSP JSP JSPSDST JSPTL JSSP MFSP MOJSP OSP PFSP PMSP RCPSP SMTTP SMTTPDST SMTWTP SOP TISP"}
+SEEDS=${SEEDS:-"1 2 3 4 5"}
+EVALS=${EVALS:-100000}
+# Evaluator calls timed on instances whose evaluations take milliseconds
+SLOW_EVALS=${SLOW_EVALS:-200}
+REPORT=${REPORT:-$BUILD/bench/results.csv}
+INSTANCES=$BUILD/bench
+
+mkdir -p "$INSTANCES"
+rm -f "$REPORT"
+
+# Taillard's generator (E. Taillard, Benchmarks for basic scheduling
+# problems, 1993): a Lehmer generator giving integers in [low, high]
+TAILLARD_RNG='
+function unif(low, high,   k) {
+    k = int(seed / 127773)
+    seed = 16807 * (seed - k * 127773) - k * 2836
+    if (seed < 0) seed += 2147483647
+    return low + int(seed / 2147483647 * (high - low + 1))
+}'
+
+# Flow shop instance: one row of job times per machine
+flowshop() { # name jobs machines seed
+    awk -v n="$2" -v m="$3" -v seed="$4" "$TAILLARD_RNG"'
+    BEGIN {
+        print "number of jobs, number of machines, initial seed, upper bound and lower bound :"
+        print n, m, seed, 0, 0
+        print "processing times :"
+        for (k = 0; k < m; k++) {
+            row = ""
+            for (j = 0; j < n; j++) row = row " " unif(1, 99)
+            print row
+        }
+    }' > "$INSTANCES/$1.txt"
+}
+
+# Job shop instance: job times, then a random machine order per job
+jobshop() { # name jobs machines time_seed machine_seed
+    awk -v n="$2" -v m="$3" -v time_seed="$4" -v machine_seed="$5" "$TAILLARD_RNG"'
+    BEGIN {
+        print "Nb of jobs, Nb of Machines, Time seed, Machine seed, Upper bound, Lower bound :"
+        print n, m, time_seed, machine_seed, 0, 0
+        print "Times"
+        seed = time_seed
+        for (j = 0; j < n; j++) {
+            row = ""
+            for (k = 0; k < m; k++) row = row " " unif(1, 99)
+            print row
+        }
+        print "Machines"
+        seed = machine_seed
+        for (j = 0; j < n; j++) {
+            for (k = 0; k < m; k++) order[k] = k + 1
+            for (k = 0; k < m; k++) {
+                swap = unif(k, m - 1)
+                t = order[k]; order[k] = order[swap]; order[swap] = t
+            }
+            row = ""
+            for (k = 0; k < m; k++) row = row " " order[k]
+            print row
+        }
+    }' > "$INSTANCES/$1.txt"
+}
+
+# Job shop with setup times: the OR-Library layout (machine, time pairs with
+# 0-based machines), then a setup matrix per machine with setups in [1, 49]
+setupjobshop() { # name jobs machines seed
+    awk -v n="$2" -v m="$3" -v seed="$4" "$TAILLARD_RNG"'
+    BEGIN {
+        print "Job shop with sequence dependent setup times"
+        print n, m
+        for (j = 0; j < n; j++) {
+            for (k = 0; k < m; k++) order[k] = k
+            for (k = 0; k < m; k++) {
+                swap = unif(k, m - 1)
+                t = order[k]; order[k] = order[swap]; order[swap] = t
+            }
+            row = ""
+            for (k = 0; k < m; k++) row = row " " order[k] " " unif(1, 99)
+            print row
+        }
+        for (k = 0; k < m; k++) {
+            print "Setup times on machine " k
+            for (a = 0; a < n; a++) {
+                row = ""
+                for (b = 0; b < n; b++) row = row " " (a == b ? 0 : unif(1, 49))
+                print row
+            }
+        }
+    }' > "$INSTANCES/$1.txt"
+}
+
+# Job shop with time lags: the OR-Library layout, then per job a minimum lag
+# in [0, 9] and a maximum lag up to 50 above it between consecutive operations
+timelagjobshop() { # name jobs machines seed
+    awk -v n="$2" -v m="$3" -v seed="$4" "$TAILLARD_RNG"'
+    BEGIN {
+        print "Job shop with time lags"
+        print n, m
+        for (j = 0; j < n; j++) {
+            for (k = 0; k < m; k++) order[k] = k
+            for (k = 0; k < m; k++) {
+                swap = unif(k, m - 1)
+                t = order[k]; order[k] = order[swap]; order[swap] = t
+            }
+            row = ""
+            for (k = 0; k < m; k++) row = row " " order[k] " " unif(1, 99)
+            print row
+        }
+        print "Time lags (minimum, maximum)"
+        for (j = 0; j < n; j++) {
+            row = ""
+            for (k = 0; k < m - 1; k++) {
+                low = unif(0, 9)
+                row = row " " low " " (low + unif(0, 50))
+            }
+            print row
+        }
+    }' > "$INSTANCES/$1.txt"
+}
+
+# Project in PSPLIB layout: a dummy source and sink around activities with
+# one to three successors among the next ten. Each activity has the given
+# number of modes, with durations in [1, longest] and requests in [0, 10]
+# on about half the resources; capacities lie in [10, 20]. With more than
+# one mode there are two nonrenewable resources, each mode using [0, 10] of
+# them, with budgets halfway between the least and the most any choice of
+# modes can use.
+project() { # name activities resources longest modes seed
+    awk -v n="$2" -v k="$3" -v longest="$4" -v modes="$5" -v seed="$6" "$TAILLARD_RNG"'
+    BEGIN {
+        l = modes > 1 ? 2 : 0
+        for (a = 2; a < n; a++) {
+            count[a] = 0
+            reach = n - 1 - a < 10 ? n - 1 - a : 10
+            want = reach < 1 ? 0 : unif(1, reach < 3 ? reach : 3)
+            for (s = 0; s < want; s++) {
+                b = a + unif(1, reach)
+                if (!((a, b) in arc)) { arc[a, b] = 1; succ[a, count[a]++] = b; has_pred[b] = 1 }
+            }
+        }
+        count[1] = 0
+        for (a = 2; a < n; a++) {
+            if (!(a in has_pred)) succ[1, count[1]++] = a
+            if (count[a] == 0) succ[a, count[a]++] = n
+        }
+        count[n] = 0
+        print "************************************************************************"
+        print "projects                      :  1"
+        print "jobs (incl. supersource/sink ):  " n
+        print "RESOURCES"
+        print "  - renewable                 :  " k "   R"
+        print "  - nonrenewable              :  " l "   N"
+        print "************************************************************************"
+        print "PRECEDENCE RELATIONS:"
+        print "jobnr.    #modes  #successors   successors"
+        for (a = 1; a <= n; a++) {
+            row = a "  " (a == 1 || a == n ? 1 : modes) "  " count[a]
+            for (s = 0; s < count[a]; s++) row = row "  " succ[a, s]
+            print row
+        }
+        print "************************************************************************"
+        print "REQUESTS/DURATIONS:"
+        print "jobnr. mode duration  R 1 ..."
+        print "------------------------------------------------------------------------"
+        for (a = 1; a <= n; a++) {
+            dummy = a == 1 || a == n
+            for (m = 1; m <= (dummy ? 1 : modes); m++) {
+                row = (m == 1 ? a : "") "  " m "  " (dummy ? 0 : unif(1, longest))
+                for (r = 0; r < k; r++) row = row "  " (dummy || unif(0, 1) ? 0 : unif(1, 10))
+                for (r = 0; r < l; r++) {
+                    use = dummy ? 0 : unif(0, 10)
+                    if (m == 1 || use < least[a, r]) least[a, r] = use
+                    if (m == 1 || use > most[a, r]) most[a, r] = use
+                    row = row "  " use
+                }
+                print row
+            }
+        }
+        print "************************************************************************"
+        print "RESOURCEAVAILABILITIES:"
+        print "  R 1 ..."
+        row = ""
+        for (r = 0; r < k; r++) row = row "  " unif(10, 20)
+        for (r = 0; r < l; r++) {
+            low = high = 0
+            for (a = 1; a <= n; a++) { low += least[a, r]; high += most[a, r] }
+            row = row "  " int((low + high) / 2)
+        }
+        print row
+    }' > "$INSTANCES/$1.sm"
+}
+
+# Portfolio of projects sharing four resources of capacity 40
+portfolio() { # name projects activities longest modes seed
+    echo "$2 4" > "$INSTANCES/$1.txt"
+    echo "40 40 40 40" >> "$INSTANCES/$1.txt"
+    for p in $(seq 1 "$2"); do
+        project "$1-$p" "$3" 4 "$4" "$5" $(($6 + p))
+        echo "$1-$p.sm" >> "$INSTANCES/$1.txt"
+    done
+}
+
+# Weighted tardiness instances in the OR-Library layout, 20 numbers per line:
+# per instance the times in [1, 100], the weights in [1, 10], then due dates
+# in [P (1 - TF - RDD / 2), P (1 - TF + RDD / 2)] (no less than 0), for total
+# time P, tardiness factor TF and relative range of due dates RDD, each
+# stepping through 0.2 to 1.0 from one instance to the next
+tardiness() { # name jobs instances seed
+    awk -v n="$2" -v count="$3" -v seed="$4" "$TAILLARD_RNG"'
+    function put(value) {
+        row = row " " value
+        if (++column == 20) { print row; row = ""; column = 0 }
+    }
+    BEGIN {
+        for (i = 0; i < count; i++) {
+            tf = 0.2 * (1 + i % 5)
+            rdd = 0.2 * (1 + int(i / 5) % 5)
+            total = 0
+            for (j = 0; j < n; j++) { p[j] = unif(1, 100); total += p[j] }
+            for (j = 0; j < n; j++) put(p[j])
+            for (j = 0; j < n; j++) put(unif(1, 10))
+            low = int(total * (1 - tf - rdd / 2)); if (low < 0) low = 0
+            high = int(total * (1 - tf + rdd / 2)); if (high < low) high = low
+            for (j = 0; j < n; j++) put(unif(low, high))
+        }
+        if (column > 0) print row
+    }' > "$INSTANCES/$1.txt"
+}
+
+flowshop ta001 20 5 873654221
+flowshop ta011 20 10 587595453
+flowshop ta021 20 20 479340445
+flowshop ta101 200 20 471503045
+flowshop ta111 500 20 1368624604
+jobshop ta01 15 15 840612802 398197754
+setupjobshop sdst100 100 10 1234567
+setupjobshop sdst300 300 10 7654321
+timelagjobshop tl50 50 10 2468013
+timelagjobshop tl200 200 10 1357924
+project p120 122 4 10 1 1122334
+project p1000 1002 4 100 1 5566778
+project mm120 122 4 10 3 9988776
+portfolio pf30 30 100 10 3 3141592
+tardiness wt40 40 25 2718281
+
+# Options after the solver override the defaults, so a line can lower the
+# evaluator calls with --bench-evals
+run() { # solver [options...]
+    solver=$1
+    shift
+    for seed in $SEEDS; do
+        # CSP asks for its number of tasks on stdin
+        echo 10 | "$BUILD/$solver" --seed "$seed" --bench-evals "$EVALS" --report "$REPORT" "$@" > /dev/null
+    done
+}
+
+# Every solver on its built-in example
+for solver in $SOLVERS; do
+    run "$solver"
+done
+
+# Taillard instances, with targets about 5% above the best known makespans
+run PFSP --instance "$INSTANCES/ta001.txt" --target 1342
+run PFSP --instance "$INSTANCES/ta011.txt" --target 1661
+run PFSP --instance "$INSTANCES/ta021.txt" --target 2412
+run PFSP --instance "$INSTANCES/ta101.txt"
+run PFSP --instance "$INSTANCES/ta111.txt"
+run PFSP --instance "$INSTANCES/ta101.txt" --initial neh
+run PFSP --instance "$INSTANCES/ta111.txt" --initial neh
+run MFSP --instance "$INSTANCES/ta001.txt" --target 1342
+run MFSP --instance "$INSTANCES/ta101.txt"
+run MFSP --instance "$INSTANCES/ta101.txt" --candidates 8
+run JSP --instance "$INSTANCES/ta01.txt" --target 1293
+run JSPSDST --instance "$INSTANCES/sdst100.txt"
+run JSPSDST --instance "$INSTANCES/sdst300.txt"
+run JSPTL --instance "$INSTANCES/tl50.txt"
+run JSPTL --instance "$INSTANCES/tl200.txt" --bench-evals "$SLOW_EVALS"
+# Estimated initial temperature: from most random starts every feasible
+# neighbour is better, so the estimate comes from the random walk, and
+# infeasible time-lag moves (infinite cost) are left out of it
+run JSPTL --instance "$INSTANCES/tl50.txt" --auto-temperature
+run JSPTL --instance "$INSTANCES/tl50.txt" --schedule lam
+run SMTWTP --instance "$INSTANCES/wt40.txt"
+run SMTWTP --instance "$INSTANCES/wt40.txt" --index 19
+run SMTTP --instance "$INSTANCES/wt40.txt"
+run SMTTP --instance "$INSTANCES/wt40.txt" --index 19
+run RCPSP --instance "$INSTANCES/p120.sm"
+run RCPSP --instance "$INSTANCES/p1000.sm" --time-limit 20 --bench-evals "$SLOW_EVALS"
+run RCPSP --instance "$INSTANCES/mm120.sm"
+run RCPSP --instance "$INSTANCES/pf30.txt" --format portfolio --time-limit 20 --bench-evals "$SLOW_EVALS"
+
+echo "Results written to $REPORT"
@@ -0,0 +1,1075 @@
+// Simulated Annealing engine shared by the scheduling problems
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "sa.h"
+#include "sa_trace.h"
+
+// Print the shared options
+static void print_usage(const char *program) {
+    fprintf(stderr, "usage: %s [--seed N] [--threads N] [--restarts K] [--replicas R] [--exchange-interval M]\n"
+                    "       [--instance PATH [--format NAME] [--index K]]\n"
+                    "       [--target C] [--report PATH] [--bench-evals N] [--trace PATH]\n"
+                    "       [--time-limit SECONDS] [--schedule geometric|lam] [--auto-temperature]\n"
+                    "       [--candidates K] [--initial NAME]\n", program);
+}
+
+// Parse a non-negative integer option value
+static int parse_count(const char *text, int *value) {
+    char *end;
+    long parsed = strtol(text, &end, 10);
+    if (*end != '\0' || parsed < 0 || parsed > 1000000) {
+        return -1;
+    }
+    *value = (int)parsed;
+    return 0;
+}
+
+int sa_parse_options(int argc, char **argv, sa_options *options) {
+    int seeded = 0;
+    options->threads = -1;
+    options->restarts = 0;
+    options->replicas = 0;
+    options->exchange_interval = 100;
+    options->instance = NULL;
+    options->format = NULL;
+    options->index = 1;
+    options->target = -INFINITY;
+    options->report = NULL;
+    options->bench_evals = 0;
+    options->trace = NULL;
+    options->time_limit = 0.0;
+    options->schedule = SA_SCHEDULE_GEOMETRIC;
+    options->auto_temperature = 0;
+    options->candidates = 1;
+    options->initial = NULL;
+    const char *slash = strrchr(argv[0], '/');
+    options->program = slash != NULL ? slash + 1 : argv[0];
+    for (int i = 1; i < argc; i++) {
+        int status = 0;
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            char *end;
+            options->seed = strtoull(argv[++i], &end, 0);
+            status = *end != '\0' ? -1 : 0;
+            seeded = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            status = parse_count(argv[++i], &options->threads);
+        } else if (strcmp(argv[i], "--restarts") == 0 && i + 1 < argc) {
+            status = parse_count(argv[++i], &options->restarts);
+            if (options->restarts == 0) {
+                status = -1;
+            }
+        } else if (strcmp(argv[i], "--replicas") == 0 && i + 1 < argc) {
+            status = parse_count(argv[++i], &options->replicas);
+        } else if (strcmp(argv[i], "--exchange-interval") == 0 && i + 1 < argc) {
+            status = parse_count(argv[++i], &options->exchange_interval);
+            if (options->exchange_interval == 0) {
+                status = -1;
+            }
+        } else if (strcmp(argv[i], "--instance") == 0 && i + 1 < argc) {
+            options->instance = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            options->format = argv[++i];
+        } else if (strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+            status = parse_count(argv[++i], &options->index);
+            if (options->index == 0) {
+                status = -1;
+            }
+        } else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+            char *end;
+            options->target = strtod(argv[++i], &end);
+            status = *end != '\0' ? -1 : 0;
+        } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            options->report = argv[++i];
+        } else if (strcmp(argv[i], "--bench-evals") == 0 && i + 1 < argc) {
+            status = parse_count(argv[++i], &options->bench_evals);
+        } else if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc) {
+            char *end;
+            options->time_limit = strtod(argv[++i], &end);
+            status = *end != '\0' || !(options->time_limit > 0) ? -1 : 0;
+        } else if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "geometric") == 0) {
+                options->schedule = SA_SCHEDULE_GEOMETRIC;
+            } else if (strcmp(argv[i], "lam") == 0) {
+                options->schedule = SA_SCHEDULE_LAM;
+            } else {
+                status = -1;
+            }
+        } else if (strcmp(argv[i], "--auto-temperature") == 0) {
+            options->auto_temperature = 1;
+        } else if (strcmp(argv[i], "--candidates") == 0 && i + 1 < argc) {
+            status = parse_count(argv[++i], &options->candidates);
+            if (options->candidates == 0) {
+                status = -1;
+            }
+        } else if (strcmp(argv[i], "--initial") == 0 && i + 1 < argc) {
+            options->initial = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options->trace = argv[++i];
+        } else {
+            status = -1;
+        }
+        if (status != 0) {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+    if (options->threads < 0) {
+        options->threads = options->replicas > 1 ? options->replicas : 1;
+    }
+    if (options->threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        options->threads = online > 0 ? (int)online : 1;
+    }
+    if (options->restarts == 0) {
+        options->restarts = options->threads;
+    }
+    if (!seeded) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        options->seed = (unsigned long long)now.tv_sec * 1000000007ULL + (unsigned long long)now.tv_nsec;
+        fprintf(stderr, "Seed = %llu\n", options->seed);
+    }
+    return 0;
+}
+
+// A move to new_cost passes exp((current - new) / T) >= u exactly when
+// new <= current - T * ln(u), so the test becomes a bound on the new cost
+double sa_threshold(sa_rng *rng, double current_cost, double temperature) {
+    double u = 1.0 - sa_rng_uniform(rng); // uniform in (0, 1]
+    return current_cost - temperature * log(u);
+}
+
+// Monotonic wall-clock time in seconds
+static double seconds_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Check whether the iteration limit has been reached
+static int iterations_exhausted(const sa_params *params, const sa_stats *stats) {
+    return params->max_iterations > 0 && stats->iterations >= params->max_iterations;
+}
+
+// Settings of a chain taken from the command line
+typedef struct {
+    double target;        // Stop once the best cost reaches this
+    double time_limit;    // Seconds per chain; replaces the schedule's own end (0 = off)
+    sa_schedule schedule; // How the temperature is lowered
+    sa_trace *trace;      // Telemetry (NULL = off)
+    int candidates;       // Moves proposed per step
+    atomic_int *stop;     // Set once any chain sharing it reaches the target (NULL = not shared)
+} chain_config;
+
+// One annealing chain: the state, its random stream and its running costs
+typedef struct {
+    const sa_problem *problem;
+    void *state;
+    sa_rng *rng;
+    void *move;           // candidates move records, move_size bytes apart
+    double *costs;        // Costs of the candidates (NULL with one candidate)
+    int candidates;
+    double current_cost;
+    double best_cost;
+    double target;
+    atomic_int *stop;
+    double started;
+    sa_stats stats;
+    // Telemetry (trace is NULL when off): counters at the end of the last step
+    sa_trace *trace;
+    long step;
+    long step_iterations;
+    long step_accepted;
+    long step_evaluations;
+    double step_time;
+} chain;
+
+// Record the time at which the best cost first reaches the target, and tell
+// the other chains to stop
+static void check_target(chain *c) {
+    if (c->best_cost <= c->target && c->stats.time_to_target < 0) {
+        c->stats.time_to_target = seconds_now() - c->started;
+        if (c->stop != NULL) {
+            atomic_store_explicit(c->stop, 1, memory_order_relaxed);
+        }
+    }
+}
+
+static int target_reached(const chain *c) {
+    return c->stats.time_to_target >= 0;
+}
+
+// Check whether this chain or one sharing its stop flag has reached the target
+static int chain_stopped(const chain *c) {
+    return target_reached(c) || (c->stop != NULL && atomic_load_explicit(c->stop, memory_order_relaxed));
+}
+
+static void chain_start(chain *c, const sa_problem *problem, void *state, sa_rng *rng,
+                        const chain_config *config) {
+    c->problem = problem;
+    c->state = state;
+    c->rng = rng;
+    c->candidates = config->candidates > 1 ? config->candidates : 1;
+    c->move = malloc(problem->move_size > 0 ? c->candidates * problem->move_size : 1);
+    c->costs = c->candidates > 1 ? malloc(c->candidates * sizeof(double)) : NULL;
+    c->started = seconds_now();
+    c->current_cost = problem->cost(state, INFINITY);
+    c->best_cost = c->current_cost;
+    c->target = config->target;
+    c->stop = config->stop;
+    problem->save_best(state);
+    c->stats.iterations = 0;
+    c->stats.accepted = 0;
+    c->stats.improvements = 0;
+    c->stats.evaluations = 1;
+    c->stats.time_to_target = -1;
+    check_target(c);
+    c->trace = NULL;
+}
+
+// Enable telemetry for a chain
+static void chain_trace(chain *c, sa_trace *trace) {
+    c->trace = trace;
+    c->step = 0;
+    c->step_iterations = c->stats.iterations;
+    c->step_accepted = c->stats.accepted;
+    c->step_evaluations = c->stats.evaluations;
+    c->step_time = seconds_now();
+}
+
+// Queue the statistics of the step just finished into ring slot of the trace
+static void trace_step(chain *c, int slot, double temperature) {
+    if (c->trace == NULL) {
+        return;
+    }
+    double now = seconds_now();
+    long evaluations = c->stats.evaluations - c->step_evaluations;
+    sa_trace_record record = {
+        .chain = slot,
+        .step = c->step++,
+        .temperature = temperature,
+        .moves = c->stats.iterations - c->step_iterations,
+        .accepted = c->stats.accepted - c->step_accepted,
+        .current_cost = c->current_cost,
+        .best_cost = c->best_cost,
+        .evaluations = c->stats.evaluations,
+        .ns_per_evaluation = evaluations > 0 ? (now - c->step_time) * 1e9 / evaluations : 0.0,
+    };
+    sa_trace_push(c->trace, &record);
+    c->step_iterations = c->stats.iterations;
+    c->step_accepted = c->stats.accepted;
+    c->step_evaluations = c->stats.evaluations;
+    c->step_time = now;
+}
+
+// Record an accepted move that led to new_cost (an estimate if the problem's
+// evaluations are, in which case the exact cost is computed here)
+static void chain_accept(chain *c, double new_cost) {
+    if (c->problem->estimated) {
+        new_cost = c->problem->cost(c->state, INFINITY);
+        c->stats.evaluations++;
+    }
+    c->current_cost = new_cost;
+    c->stats.accepted++;
+    // Update the best solution found so far
+    if (c->current_cost < c->best_cost) {
+        if (c->problem->intensify != NULL) {
+            c->current_cost = c->problem->intensify(c->state, c->current_cost);
+            c->stats.evaluations++;
+        }
+        c->best_cost = c->current_cost;
+        c->problem->save_best(c->state);
+        c->stats.improvements++;
+        check_target(c);
+    }
+}
+
+// Cost of a neighbour of the current solution, leaving the solution unchanged
+static double neighbour_cost(const sa_problem *problem, void *state, const void *move, double limit) {
+    if (problem->evaluate != NULL) {
+        return problem->evaluate(state, move, limit);
+    }
+    problem->apply(state, move);
+    double cost = problem->cost(state, limit);
+    problem->undo(state, move);
+    return cost;
+}
+
+// Propose c->candidates moves and submit the cheapest one found to the
+// acceptance test
+static void chain_step_best(chain *c, double temperature) {
+    const sa_problem *problem = c->problem;
+    char *moves = c->move;
+    size_t size = problem->move_size;
+    int count = 0;
+    c->stats.iterations++;
+    for (int k = 0; k < c->candidates; k++) {
+        count += problem->propose(c->state, c->rng, moves + count * size) != 0;
+    }
+    if (count == 0) {
+        return;
+    }
+    c->stats.evaluations += count;
+    double limit = sa_threshold(c->rng, c->current_cost, temperature);
+    if (problem->evaluate_batch != NULL) {
+        problem->evaluate_batch(c->state, moves, count, limit, c->costs);
+    } else {
+        for (int k = 0; k < count; k++) {
+            c->costs[k] = neighbour_cost(problem, c->state, moves + k * size, limit);
+        }
+    }
+    int best = 0;
+    for (int k = 1; k < count; k++) {
+        if (c->costs[k] < c->costs[best]) {
+            best = k;
+        }
+    }
+    if (c->costs[best] > limit) {
+        return;
+    }
+    problem->apply(c->state, moves + best * size);
+    chain_accept(c, c->costs[best]);
+}
+
+// Propose one move and accept or reject it at this temperature
+static void chain_step(chain *c, double temperature) {
+    const sa_problem *problem = c->problem;
+    double new_cost;
+    if (c->candidates > 1) {
+        chain_step_best(c, temperature);
+        return;
+    }
+    c->stats.iterations++;
+    if (!problem->propose(c->state, c->rng, c->move)) {
+        return;
+    }
+    c->stats.evaluations++;
+    double limit = sa_threshold(c->rng, c->current_cost, temperature);
+    if (problem->evaluate != NULL) {
+        new_cost = problem->evaluate(c->state, c->move, limit);
+        if (new_cost > limit) {
+            return;
+        }
+        problem->apply(c->state, c->move);
+    } else {
+        problem->apply(c->state, c->move);
+        new_cost = problem->cost(c->state, limit);
+        if (new_cost > limit) {
+            problem->undo(c->state, c->move);
+            return;
+        }
+    }
+    chain_accept(c, new_cost);
+}
+
+static void chain_finish(chain *c) {
+    free(c->move);
+    free(c->costs);
+    c->stats.best_cost = c->best_cost;
+    c->stats.current_cost = c->current_cost;
+    c->stats.elapsed = seconds_now() - c->started;
+}
+
+// Moves in the annealing schedule: the iteration limit or the number of
+// cooling steps down to the final temperature, whichever comes first
+static long schedule_moves(const sa_params *params) {
+    long per_temperature = params->iterations_per_temperature > 0 ? params->iterations_per_temperature : 1;
+    long moves = params->max_iterations;
+    if (params->min_temperature > 0 && params->cooling_rate < 1.0) {
+        double steps = ceil(log(params->min_temperature / params->initial_temperature) / log(params->cooling_rate));
+        long cooling_moves = (long)fmax(steps, 1.0) * per_temperature;
+        if (moves <= 0 || cooling_moves < moves) {
+            moves = cooling_moves;
+        }
+    }
+    return moves > 0 ? moves : 1000000;
+}
+
+// Temperature at the end of the annealing schedule. Schedules without a final
+// temperature cool for as many moves as they allow; the result is kept at
+// least a millionth of the initial temperature, below which nothing changes.
+static double schedule_final_temperature(const sa_params *params) {
+    long per_temperature = params->iterations_per_temperature > 0 ? params->iterations_per_temperature : 1;
+    double final = params->min_temperature;
+    if (final <= 0 && params->cooling_rate < 1.0) {
+        final = params->initial_temperature * pow(params->cooling_rate, (double)schedule_moves(params) / per_temperature);
+    }
+    return fmax(final, params->initial_temperature * 1e-6);
+}
+
+// Moves between clock readings and schedule updates in time-limited and
+// adaptive runs
+#define CLOCK_INTERVAL 64
+
+// Acceptance ratio the modified Lam schedule aims for after the given
+// fraction of the run: from 1 down to 0.44 over the first 15%, held at 0.44
+// until 65% and then down towards 0.001 (Swartz; Boyan, 1998)
+static double lam_target_ratio(double fraction) {
+    if (fraction < 0.15) {
+        return 0.44 + 0.56 * pow(560.0, -fraction / 0.15);
+    }
+    if (fraction < 0.65) {
+        return 0.44;
+    }
+    return 0.44 * pow(440.0, -(fraction - 0.65) / 0.35);
+}
+
+// Anneal one chain until the schedule ends or the best cost reaches the
+// target; with a trace each temperature step is recorded in ring index.
+// With a time limit or the Lam schedule the run is measured in elapsed time
+// or in moves out of schedule_moves() instead: the geometric schedule then
+// falls from the initial to the final temperature over the run, and the Lam
+// schedule nudges the temperature after every move so that the running
+// acceptance ratio follows lam_target_ratio().
+static double anneal(const sa_problem *problem, void *state, const sa_params *params, sa_rng *rng,
+                     const chain_config *config, int index, sa_stats *stats) {
+    int per_temperature = params->iterations_per_temperature > 0 ? params->iterations_per_temperature : 1;
+    chain c;
+    chain_start(&c, problem, state, rng, config);
+    if (config->trace != NULL) {
+        chain_trace(&c, config->trace);
+    }
+
+    double temperature = params->initial_temperature;
+    int timed = config->time_limit > 0;
+    int lam = config->schedule == SA_SCHEDULE_LAM;
+    if (timed || lam) {
+        long moves = schedule_moves(params);
+        double final = schedule_final_temperature(params);
+        double ratio = 1.0; // Running acceptance ratio, averaged over about 500 moves
+        for (;;) {
+            double fraction = timed ? (seconds_now() - c.started) / config->time_limit
+                                    : (double)c.stats.iterations / moves;
+            if (fraction >= 1.0 || chain_stopped(&c)) {
+                break;
+            }
+            if (!lam) {
+                temperature = params->initial_temperature * pow(final / params->initial_temperature, fraction);
+            }
+            double target_ratio = lam_target_ratio(fraction);
+            long batch = timed ? CLOCK_INTERVAL : fmin(CLOCK_INTERVAL, moves - c.stats.iterations);
+            for (long i = 0; i < batch && !chain_stopped(&c); i++) {
+                long accepted = c.stats.accepted;
+                chain_step(&c, temperature);
+                if (lam) {
+                    ratio = 0.998 * ratio + 0.002 * (c.stats.accepted - accepted);
+                    temperature = ratio > target_ratio ? temperature * 0.999 : temperature / 0.999;
+                }
+            }
+            trace_step(&c, index, temperature);
+        }
+    }
+    while (!timed && !lam && temperature > params->min_temperature &&
+           !iterations_exhausted(params, &c.stats) && !chain_stopped(&c)) {
+        for (int i = 0; i < per_temperature && !iterations_exhausted(params, &c.stats) && !chain_stopped(&c); i++) {
+            chain_step(&c, temperature);
+        }
+        trace_step(&c, index, temperature);
+        // Cool down the temperature
+        temperature *= params->cooling_rate;
+    }
+
+    chain_finish(&c);
+    if (stats != NULL) {
+        *stats = c.stats;
+    }
+    return c.best_cost;
+}
+
+double sa_run(const sa_problem *problem, void *state, const sa_params *params, sa_rng *rng, sa_stats *stats) {
+    chain_config config = {-INFINITY, 0.0, SA_SCHEDULE_GEOMETRIC, NULL, 1, NULL};
+    return anneal(problem, state, params, rng, &config, 0, stats);
+}
+
+// Independent chains shared by the worker threads
+typedef struct {
+    const sa_problem *problem;
+    const sa_params *params;
+    void **states;
+    sa_rng *rngs;
+    sa_stats *stats;
+    chain_config config;
+    int chains;
+    atomic_int next_chain;
+    atomic_int stop;     // Set once a chain reaches the target; no more chains start
+} chain_pool;
+
+// Worker thread: take the next chain that has not been started and anneal it,
+// until every chain has run or one has reached the target
+static void *run_chains(void *arg) {
+    chain_pool *pool = arg;
+    for (;;) {
+        if (atomic_load(&pool->stop)) {
+            break;
+        }
+        int chain = atomic_fetch_add(&pool->next_chain, 1);
+        if (chain >= pool->chains) {
+            break;
+        }
+        if (chain > 0 && pool->problem->restart != NULL) {
+            pool->problem->restart(pool->states[chain], &pool->rngs[chain]);
+        }
+        anneal(pool->problem, pool->states[chain], pool->params, &pool->rngs[chain], &pool->config, chain,
+               &pool->stats[chain]);
+    }
+    return NULL;
+}
+
+// Copy a state, either with the problem's clone() or as a flat block
+static void *clone_state(const sa_problem *problem, const void *state) {
+    if (problem->clone != NULL) {
+        return problem->clone(state);
+    }
+    void *copy = malloc(problem->state_size);
+    memcpy(copy, state, problem->state_size);
+    return copy;
+}
+
+static void copy_state(const sa_problem *problem, void *dest, const void *src) {
+    if (problem->copy != NULL) {
+        problem->copy(dest, src);
+    } else {
+        memcpy(dest, src, problem->state_size);
+    }
+}
+
+static void destroy_state(const sa_problem *problem, void *state) {
+    if (problem->destroy != NULL) {
+        problem->destroy(state);
+    } else {
+        free(state);
+    }
+}
+
+// Spread of the chains' final costs
+typedef struct {
+    double best;
+    double mean;
+    double worst;
+    double stddev;
+} cost_spread;
+
+static cost_spread chain_spread(const sa_stats *stats, int chains) {
+    cost_spread spread = {stats[0].best_cost, 0.0, stats[0].best_cost, 0.0};
+    double sum = 0.0;
+    for (int k = 0; k < chains; k++) {
+        spread.best = fmin(spread.best, stats[k].best_cost);
+        spread.worst = fmax(spread.worst, stats[k].best_cost);
+        sum += stats[k].best_cost;
+    }
+    spread.mean = sum / chains;
+    double variance = 0.0;
+    for (int k = 0; k < chains; k++) {
+        variance += (stats[k].best_cost - spread.mean) * (stats[k].best_cost - spread.mean);
+    }
+    spread.stddev = sqrt(variance / chains);
+    return spread;
+}
+
+// Summary of the chains that ran, out of chains requested
+static void print_chain_summary(const sa_stats *stats, int ran, int chains, int threads) {
+    cost_spread spread = chain_spread(stats, ran);
+    printf("Restarts: %d chains on %d threads, best %g, mean %g, worst %g, stddev %g\n",
+           ran, threads, spread.best, spread.mean, spread.worst, spread.stddev);
+    if (ran < chains) {
+        printf("Target reached: %d of %d chains not started\n", chains - ran, chains);
+    }
+}
+
+// Replicas at fixed temperatures; slots[s] runs at temperatures[s], coldest first
+typedef struct {
+    chain *replicas;
+    chain **slots;
+    double *temperatures;
+    long *attempts;      // Exchange attempts between slots s and s + 1
+    long *exchanges;     // Accepted exchanges between slots s and s + 1
+    sa_rng exchange_rng;
+    int count;
+    int threads;
+    int interval;
+    long rounds;
+    double deadline;     // Clock time at which the replicas stop (0 = none)
+    int stop;            // Set at an exchange once a replica has reached the target
+    pthread_barrier_t barrier;
+} replica_pool;
+
+typedef struct {
+    replica_pool *pool;
+    int index;
+} replica_worker;
+
+// Try to exchange the solutions of neighbouring temperatures, alternating
+// between even and odd pairs. Slots s (colder) and s + 1 swap with
+// probability min(1, exp((1/T_s - 1/T_s+1) * (E_s - E_s+1))).
+static void exchange_replicas(replica_pool *pool, long round) {
+    for (int s = (int)(round % 2); s + 1 < pool->count; s += 2) {
+        chain *cold = pool->slots[s], *hot = pool->slots[s + 1];
+        double delta = (1.0 / pool->temperatures[s] - 1.0 / pool->temperatures[s + 1]) *
+                       (cold->current_cost - hot->current_cost);
+        pool->attempts[s]++;
+        if (delta >= 0 || sa_rng_uniform(&pool->exchange_rng) < exp(delta)) {
+            pool->slots[s] = hot;
+            pool->slots[s + 1] = cold;
+            pool->exchanges[s]++;
+        }
+    }
+    for (int s = 0; s < pool->count; s++) {
+        pool->stop |= target_reached(pool->slots[s]);
+    }
+    if (pool->deadline > 0 && seconds_now() >= pool->deadline) {
+        pool->stop = 1;
+    }
+}
+
+// Worker thread: advance its slots by one interval, then wait for the exchange
+static void *run_replicas(void *arg) {
+    replica_worker *worker = arg;
+    replica_pool *pool = worker->pool;
+    for (long round = 0; round < pool->rounds; round++) {
+        for (int s = worker->index; s < pool->count; s += pool->threads) {
+            for (int i = 0; i < pool->interval; i++) {
+                chain_step(pool->slots[s], pool->temperatures[s]);
+            }
+            trace_step(pool->slots[s], s, pool->temperatures[s]);
+        }
+        if (pthread_barrier_wait(&pool->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            exchange_replicas(pool, round);
+        }
+        pthread_barrier_wait(&pool->barrier);
+        if (pool->stop) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+// Run the replicas on threads workers, leave the best one in state and return
+// its index; stats receives the counters of every replica
+static int replica_exchange(const sa_problem *problem, void *state, const sa_params *params,
+                            const sa_options *options, sa_rng *rng, int threads,
+                            const chain_config *config, sa_stats *stats) {
+    replica_pool pool;
+    int count = options->replicas;
+    pool.count = count;
+    pool.threads = threads;
+    pool.stop = 0;
+    pool.interval = options->exchange_interval;
+    pool.rounds = (schedule_moves(params) + pool.interval - 1) / pool.interval;
+    pool.deadline = 0;
+    if (config->time_limit > 0) {
+        // Exchange until the budget runs out instead
+        pool.rounds = LONG_MAX;
+        pool.deadline = seconds_now() + config->time_limit;
+    }
+    pool.replicas = malloc(count * sizeof(chain));
+    pool.slots = malloc(count * sizeof(chain *));
+    pool.temperatures = malloc(count * sizeof(double));
+    pool.attempts = calloc(count, sizeof(long));
+    pool.exchanges = calloc(count, sizeof(long));
+    sa_rng *rngs = malloc(count * sizeof(sa_rng));
+
+    // Geometric ladder from the final temperature (slot 0) up to the initial one;
+    // a vanishing final temperature is raised to keep neighbours exchanging
+    double hot = params->initial_temperature;
+    double cold = fmax(params->min_temperature, hot * 1e-3);
+    for (int s = 0; s < count; s++) {
+        pool.temperatures[s] = cold * pow(hot / cold, (double)s / (count - 1));
+    }
+    sa_rng_split(rng, &pool.exchange_rng);
+    for (int r = 0; r < count; r++) {
+        sa_rng_split(rng, &rngs[r]);
+        void *replica_state = state;
+        if (r > 0) {
+            replica_state = clone_state(problem, state);
+            if (problem->restart != NULL) {
+                problem->restart(replica_state, &rngs[r]);
+            }
+        }
+        chain_start(&pool.replicas[r], problem, replica_state, &rngs[r], config);
+        if (config->trace != NULL) {
+            chain_trace(&pool.replicas[r], config->trace);
+        }
+        pool.slots[r] = &pool.replicas[r];
+    }
+
+    pthread_barrier_init(&pool.barrier, NULL, pool.threads);
+    pthread_t *handles = malloc(pool.threads * sizeof(pthread_t));
+    replica_worker *workers = malloc(pool.threads * sizeof(replica_worker));
+    for (int t = 0; t < pool.threads; t++) {
+        workers[t].pool = &pool;
+        workers[t].index = t;
+        if (t > 0) {
+            pthread_create(&handles[t], NULL, run_replicas, &workers[t]);
+        }
+    }
+    run_replicas(&workers[0]);
+    for (int t = 1; t < pool.threads; t++) {
+        pthread_join(handles[t], NULL);
+    }
+    pthread_barrier_destroy(&pool.barrier);
+
+    // Keep the replica with the best solution in the caller's state
+    int best_replica = 0;
+    for (int r = 0; r < count; r++) {
+        chain_finish(&pool.replicas[r]);
+        stats[r] = pool.replicas[r].stats;
+        if (pool.replicas[r].best_cost < pool.replicas[best_replica].best_cost) {
+            best_replica = r;
+        }
+    }
+    if (best_replica != 0) {
+        copy_state(problem, state, pool.replicas[best_replica].state);
+    }
+    printf("Replica exchange: %d replicas on %d threads, T %g to %g, best %g, exchange rates",
+           count, pool.threads, cold, hot, pool.replicas[best_replica].best_cost);
+    for (int s = 0; s + 1 < count; s++) {
+        printf(" %.2f", pool.attempts[s] > 0 ? (double)pool.exchanges[s] / pool.attempts[s] : 0.0);
+    }
+    printf("\n");
+
+    for (int r = 1; r < count; r++) {
+        destroy_state(problem, pool.replicas[r].state);
+    }
+    free(workers);
+    free(handles);
+    free(rngs);
+    free(pool.exchanges);
+    free(pool.attempts);
+    free(pool.temperatures);
+    free(pool.slots);
+    free(pool.replicas);
+    return best_replica;
+}
+
+// Run the independent chains on threads workers, leave the best one in state
+// and return its index. Once a chain reaches the target the others stop and
+// no more start; ran receives the number of chains started, and stats the
+// counters of each of them.
+static int multi_start(const sa_problem *problem, void *state, const sa_params *params,
+                       sa_rng *rng, int chains, int threads, const chain_config *config, sa_stats *stats,
+                       int *ran) {
+    chain_pool pool;
+    pool.problem = problem;
+    pool.params = params;
+    pool.chains = chains;
+    pool.config = *config;
+    pool.config.stop = &pool.stop;
+    pool.states = malloc(chains * sizeof(void *));
+    pool.rngs = malloc(chains * sizeof(sa_rng));
+    pool.stats = stats;
+    atomic_init(&pool.next_chain, 0);
+    atomic_init(&pool.stop, 0);
+    // Chain k always gets the k-th stream, so results do not depend on the thread count
+    for (int k = 0; k < chains; k++) {
+        pool.states[k] = k == 0 ? state : clone_state(problem, state);
+        sa_rng_split(rng, &pool.rngs[k]);
+    }
+
+    pthread_t *workers = malloc(threads * sizeof(pthread_t));
+    for (int t = 1; t < threads; t++) {
+        pthread_create(&workers[t], NULL, run_chains, &pool);
+    }
+    run_chains(&pool);
+    for (int t = 1; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    int started = atomic_load(&pool.next_chain);
+    *ran = started < chains ? started : chains;
+
+    // Keep the best chain in the caller's state
+    int best_chain = 0;
+    for (int k = 1; k < *ran; k++) {
+        if (stats[k].best_cost < stats[best_chain].best_cost) {
+            best_chain = k;
+        }
+    }
+    if (best_chain != 0) {
+        copy_state(problem, state, pool.states[best_chain]);
+    }
+    print_chain_summary(stats, *ran, chains, threads);
+
+    for (int k = 1; k < chains; k++) {
+        destroy_state(problem, pool.states[k]);
+    }
+    free(workers);
+    free(pool.rngs);
+    free(pool.states);
+    return best_chain;
+}
+
+// Neighbours sampled to estimate the initial temperature
+#define TEMPERATURE_SAMPLES 200
+// Steps of the random walk that looks for uphill moves when the starting
+// solution has none, and the uphill moves it collects before stopping
+#define TEMPERATURE_WALK_STEPS (10 * TEMPERATURE_SAMPLES)
+#define TEMPERATURE_WALK_UPHILL 20
+
+// Cost of a move from the current solution, whose cost is current, added to
+// *uphill when it goes uphill by a finite amount; returns the neighbour's cost
+static double sample_delta(const sa_problem *problem, void *state, const void *move, double current,
+                           double *uphill, int *count) {
+    double cost = neighbour_cost(problem, state, move, INFINITY);
+    double delta = cost - current;
+    if (isfinite(delta) && delta > 0) {
+        *uphill += delta;
+        (*count)++;
+    }
+    return cost;
+}
+
+// Temperature at which 80% of the uphill moves from the starting solution
+// would be accepted, exp(-mean uphill delta / T) = 0.8 (Johnson et al., 1989).
+// Infeasible neighbours (infinite cost) are left out. When no sampled move
+// goes uphill by a finite amount (a poor start whose neighbours are all
+// better, say) the moves are sampled along a short random walk from a copy
+// of the state instead, which steps to every feasible neighbour. Returns the
+// number of uphill moves averaged and leaves *temperature unchanged when
+// there are none. The moves are drawn from a copy of rng so the chains'
+// streams are unchanged.
+static int estimate_temperature(const sa_problem *problem, void *state, const sa_rng *rng, double *temperature) {
+    sa_rng sample_rng = *rng;
+    void *move = malloc(problem->move_size > 0 ? problem->move_size : 1);
+    double current = problem->cost(state, INFINITY), uphill = 0.0;
+    int count = 0;
+    for (int i = 0; i < TEMPERATURE_SAMPLES; i++) {
+        if (problem->propose(state, &sample_rng, move)) {
+            sample_delta(problem, state, move, current, &uphill, &count);
+        }
+    }
+    if (count == 0 && (problem->clone != NULL || problem->state_size > 0)) {
+        void *walker = clone_state(problem, state);
+        current = problem->cost(walker, INFINITY);
+        for (int i = 0; i < TEMPERATURE_WALK_STEPS && count < TEMPERATURE_WALK_UPHILL; i++) {
+            if (!problem->propose(walker, &sample_rng, move)) {
+                continue;
+            }
+            double cost = sample_delta(problem, walker, move, current, &uphill, &count);
+            if (isfinite(cost)) {
+                problem->apply(walker, move);
+                current = problem->estimated ? problem->cost(walker, INFINITY) : cost;
+            }
+        }
+        destroy_state(problem, walker);
+    }
+    free(move);
+    double estimate = count > 0 ? -(uphill / count) / log(0.8) : NAN;
+    if (!isfinite(estimate) || estimate <= 0) {
+        return 0;
+    }
+    *temperature = estimate;
+    return count;
+}
+
+// Evaluator throughput measured on the starting solution
+typedef struct {
+    int calls;
+    double cost_rate;      // Full cost() calls per second
+    double neighbour_rate; // Neighbours proposed and costed per second
+} evaluator_bench;
+
+// Time calls to cost() and to the neighbour evaluation the chains use (in
+// batches of candidates with evaluate_batch()), without a limit so that no
+// evaluation stops early. The proposals use a copy of rng so the annealing
+// that follows is unchanged.
+static void bench_evaluators(const sa_problem *problem, void *state, const sa_rng *rng, int calls,
+                             int candidates, evaluator_bench *bench) {
+    sa_rng bench_rng = *rng;
+    int batch = candidates > 1 && problem->evaluate_batch != NULL ? candidates : 1;
+    char *moves = malloc(problem->move_size > 0 ? batch * problem->move_size : 1);
+    double *costs = malloc(batch * sizeof(double));
+    volatile double sink = 0.0;
+    bench->calls = calls;
+
+    double started = seconds_now();
+    for (int i = 0; i < calls; i++) {
+        sink += problem->cost(state, INFINITY);
+    }
+    bench->cost_rate = calls / fmax(seconds_now() - started, 1e-9);
+
+    long costed = 0;
+    started = seconds_now();
+    for (int i = 0; i < calls; i += batch) {
+        int count = 0;
+        for (int k = 0; k < batch; k++) {
+            count += problem->propose(state, &bench_rng, moves + count * problem->move_size) != 0;
+        }
+        if (count > 1) {
+            problem->evaluate_batch(state, moves, count, INFINITY, costs);
+            sink += costs[0];
+        } else if (count == 1) {
+            sink += neighbour_cost(problem, state, moves, INFINITY);
+        }
+        costed += count;
+    }
+    bench->neighbour_rate = costed / fmax(seconds_now() - started, 1e-9);
+    (void)sink;
+    free(costs);
+    free(moves);
+    printf("Evaluator: %d calls, %.0f costs/s, %.0f neighbours/s\n", calls, bench->cost_rate, bench->neighbour_rate);
+}
+
+// Write text as a JSON string
+static void write_json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (; *text != '\0'; text++) {
+        if (*text == '"' || *text == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*text, out);
+    }
+    fputc('"', out);
+}
+
+// Check whether path ends with suffix
+static int ends_with(const char *path, const char *suffix) {
+    size_t length = strlen(path), suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(path + length - suffix_length, suffix) == 0;
+}
+
+// Append a record of the run to options->report: a JSON line for .json and
+// .jsonl files, otherwise a CSV row (with a header when the file is new)
+static void write_report(const sa_options *options, const sa_stats *stats, int chains, int threads,
+                         double elapsed, const evaluator_bench *bench) {
+    FILE *out = fopen(options->report, "a");
+    if (out == NULL) {
+        perror(options->report);
+        return;
+    }
+    long evaluations = 0, accepted = 0;
+    int reached = 0;
+    double time_to_target = -1;
+    for (int k = 0; k < chains; k++) {
+        evaluations += stats[k].evaluations;
+        accepted += stats[k].accepted;
+        if (stats[k].time_to_target >= 0) {
+            reached++;
+            if (time_to_target < 0 || stats[k].time_to_target < time_to_target) {
+                time_to_target = stats[k].time_to_target;
+            }
+        }
+    }
+    cost_spread spread = chain_spread(stats, chains);
+    const char *instance = options->instance != NULL ? options->instance : "example";
+    double seconds = fmax(elapsed, 1e-9);
+
+    if (ends_with(options->report, ".json") || ends_with(options->report, ".jsonl")) {
+        fprintf(out, "{\"solver\": ");
+        write_json_string(out, options->program);
+        fprintf(out, ", \"instance\": ");
+        write_json_string(out, instance);
+        fprintf(out, ", \"seed\": %llu, \"chains\": %d, \"threads\": %d, \"evaluations\": %ld, \"accepted\": %ld, "
+                     "\"elapsed\": %.6f, \"evaluations_per_second\": %.1f, \"accepted_per_second\": %.1f, ",
+                options->seed, chains, threads, evaluations, accepted, elapsed,
+                evaluations / seconds, accepted / seconds);
+        if (isinf(options->target)) {
+            fprintf(out, "\"target\": null, ");
+        } else {
+            fprintf(out, "\"target\": %.17g, ", options->target);
+        }
+        fprintf(out, "\"chains_at_target\": %d, \"time_to_target\": ", reached);
+        if (time_to_target >= 0) {
+            fprintf(out, "%.6f", time_to_target);
+        } else {
+            fprintf(out, "null");
+        }
+        fprintf(out, ", \"best\": %.17g, \"mean\": %.17g, \"worst\": %.17g, \"stddev\": %.17g, "
+                     "\"bench_calls\": %d, \"costs_per_second\": %.1f, \"neighbours_per_second\": %.1f}\n",
+                spread.best, spread.mean, spread.worst, spread.stddev,
+                bench->calls, bench->cost_rate, bench->neighbour_rate);
+    } else {
+        fseek(out, 0, SEEK_END);
+        if (ftell(out) == 0) {
+            fprintf(out, "solver,instance,seed,chains,threads,evaluations,accepted,elapsed,"
+                         "evaluations_per_second,accepted_per_second,target,chains_at_target,time_to_target,"
+                         "best,mean,worst,stddev,bench_calls,costs_per_second,neighbours_per_second\n");
+        }
+        fprintf(out, "%s,%s,%llu,%d,%d,%ld,%ld,%.6f,%.1f,%.1f,", options->program, instance, options->seed,
+                chains, threads, evaluations, accepted, elapsed, evaluations / seconds, accepted / seconds);
+        if (!isinf(options->target)) {
+            fprintf(out, "%.17g", options->target);
+        }
+        fprintf(out, ",%d,", reached);
+        if (time_to_target >= 0) {
+            fprintf(out, "%.6f", time_to_target);
+        }
+        fprintf(out, ",%.17g,%.17g,%.17g,%.17g,%d,%.1f,%.1f\n", spread.best, spread.mean, spread.worst,
+                spread.stddev, bench->calls, bench->cost_rate, bench->neighbour_rate);
+    }
+    fclose(out);
+}
+
+double sa_solve(const sa_problem *problem, void *state, const sa_params *params,
+                const sa_options *options, sa_rng *rng, sa_stats *stats) {
+    evaluator_bench bench = {0, 0.0, 0.0};
+    if (options->bench_evals > 0) {
+        bench_evaluators(problem, state, rng, options->bench_evals, options->candidates, &bench);
+    }
+    int copyable = problem->clone != NULL || problem->state_size > 0;
+    int replicas = copyable && options->replicas > 1;
+    int chains = replicas ? options->replicas : options->restarts > 0 ? options->restarts : 1;
+    if (!copyable) {
+        chains = 1; // the state cannot be copied
+    }
+    int threads = options->threads < chains ? options->threads : chains;
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    // An estimated initial temperature moves the whole schedule with it
+    sa_params tuned = *params;
+    if (options->auto_temperature || options->schedule == SA_SCHEDULE_LAM) {
+        double scale = 0.0;
+        if (estimate_temperature(problem, state, rng, &tuned.initial_temperature) > 0) {
+            scale = tuned.initial_temperature / params->initial_temperature;
+        }
+        if (isfinite(scale) && scale > 0) {
+            tuned.min_temperature = params->min_temperature * scale;
+            printf("Initial temperature: %g (estimated)\n", tuned.initial_temperature);
+        } else {
+            tuned.initial_temperature = params->initial_temperature;
+            printf("Initial temperature: %g (default kept, no uphill move sampled)\n", tuned.initial_temperature);
+        }
+    }
+    params = &tuned;
+    chain_config config;
+    config.target = options->target;
+    config.schedule = options->schedule;
+    config.candidates = options->candidates;
+    config.trace = options->trace != NULL ? sa_trace_open(options->trace, chains) : NULL;
+    config.stop = NULL;
+    // Chains beyond the thread count run in later waves, each with an equal share
+    int waves = replicas ? 1 : (chains + threads - 1) / threads;
+    config.time_limit = options->time_limit / waves;
+    sa_stats *all = malloc(chains * sizeof(sa_stats));
+    double started = seconds_now();
+    int best = 0;
+    if (replicas) {
+        best = replica_exchange(problem, state, params, options, rng, threads, &config, all);
+    } else if (chains > 1) {
+        best = multi_start(problem, state, params, rng, chains, threads, &config, all, &chains);
+    } else {
+        anneal(problem, state, params, rng, &config, 0, &all[0]);
+    }
+    double elapsed = seconds_now() - started;
+    if (config.trace != NULL) {
+        sa_trace_close(config.trace);
+    }
+
+    if (options->report != NULL) {
+        write_report(options, all, chains, threads, elapsed, &bench);
+    }
+    if (stats != NULL) {
+        *stats = all[best];
+    }
+    double best_cost = all[best].best_cost;
+    free(all);
+    return best_cost;
+}
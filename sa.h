@@ -0,0 +1,148 @@
+// Simulated Annealing engine shared by the scheduling problems
+#ifndef SA_H
+#define SA_H
+
+#include <stddef.h>
+#include "sa_rng.h"
+
+// Annealing schedule (geometric cooling)
+typedef struct {
+    double initial_temperature;     // Starting temperature
+    double cooling_rate;            // temperature *= cooling_rate after each step
+    double min_temperature;         // Stop once the temperature drops to this value
+    long max_iterations;            // Stop after this many moves (0 = no limit)
+    int iterations_per_temperature; // Moves tried before each cooling step (0 = 1)
+} sa_params;
+
+// Problem interface
+// propose() writes a move record of move_size bytes and returns 1, or
+// returns 0 when it finds no move; the step then counts as an iteration
+// but neither evaluates nor accepts anything. If evaluate() is given it
+// returns the cost of the neighbour without changing the solution and apply()
+// is only called for accepted moves. Otherwise the engine applies the move,
+// calls cost() on the modified solution and calls undo() if it is rejected.
+// save_best() is called whenever the current solution becomes the best one.
+// cost() and evaluate() receive the largest cost that would still be accepted;
+// they may stop early and return any value above it once it is exceeded.
+// An infeasible solution or neighbour may cost INFINITY; such a move is
+// never accepted, and the initial temperature estimate leaves it out.
+// A problem whose evaluate() only estimates the neighbour's cost sets
+// estimated: moves are accepted on the estimate, and the engine then takes
+// the exact cost of the new solution from cost().
+// For restarts the engine copies the state: a state without owned pointers
+// only sets state_size, other states provide clone(), copy() and destroy().
+// restart() draws a new random starting solution for the extra chains.
+// evaluate_batch() is optional: it writes to costs[c] the cost of each of the
+// count move records in moves (move_size bytes apart), like evaluate() with
+// the same limit, and lets a problem score many neighbours in one pass.
+// intensify() is optional: called with the cost of the current solution
+// whenever an accepted move makes it the best so far, it may improve the
+// solution in place (a local search, say) and returns its cost, no higher.
+typedef struct {
+    size_t move_size;
+    size_t state_size;
+    int estimated;
+    void *(*clone)(const void *state);
+    void (*copy)(void *dest, const void *src);
+    void (*destroy)(void *state);
+    void (*restart)(void *state, sa_rng *rng);
+    double (*cost)(void *state, double limit);
+    int (*propose)(void *state, sa_rng *rng, void *move);
+    double (*evaluate)(void *state, const void *move, double limit);
+    void (*evaluate_batch)(void *state, const void *moves, int count, double limit, double *costs);
+    void (*apply)(void *state, const void *move);
+    void (*undo)(void *state, const void *move);
+    void (*save_best)(void *state);
+    double (*intensify)(void *state, double cost);
+} sa_problem;
+
+// Counters collected during a run
+typedef struct {
+    double best_cost;
+    double current_cost;
+    long iterations;
+    long accepted;
+    long improvements;
+    long evaluations;      // Calls to cost() and evaluate()
+    double elapsed;        // Wall-clock seconds spent annealing
+    double time_to_target; // Seconds until the best cost reached the target (-1 = never)
+} sa_stats;
+
+// Cooling schedules selectable from the command line
+typedef enum {
+    SA_SCHEDULE_GEOMETRIC, // temperature *= cooling_rate, as set by the solver
+    SA_SCHEDULE_LAM,       // Modified Lam: steer the acceptance ratio along a target curve
+} sa_schedule;
+
+// Command line options shared by all solvers
+typedef struct {
+    unsigned long long seed; // Seed of the random number generator
+    int threads;             // Worker threads for independent chains
+    int restarts;            // Independent chains, the best one is kept
+    int replicas;            // Replica exchange ladder size (0 = off)
+    int exchange_interval;   // Moves per replica between exchange attempts
+    const char *instance;    // Instance file to load (NULL = built-in example)
+    const char *format;      // Instance file format (NULL = the solver's default)
+    int index;               // Instance within a multi-instance file, from 1
+    double target;           // Stop once a chain's best cost reaches this (-INFINITY = never); with
+                             // restarts the other chains stop too and queued ones never start
+    const char *report;      // File that a CSV or JSON record of the run is appended to
+    int bench_evals;         // Time this many evaluator calls before annealing (0 = off)
+    const char *program;     // Solver name recorded in reports
+    const char *trace;       // File that per-step telemetry is written to (NULL = off)
+    double time_limit;       // Wall-clock budget in seconds for the annealing (0 = the schedule's own)
+    sa_schedule schedule;    // Cooling schedule
+    int auto_temperature;    // Estimate the initial temperature from sampled moves
+    int candidates;          // Moves proposed per step; the best one faces the acceptance test
+    const char *initial;     // Starting solution heuristic (NULL = the solver's default)
+} sa_options;
+
+// Parse the shared options (--seed N, --threads N, --restarts K, --replicas R,
+// --exchange-interval M, --instance PATH, --format NAME, --index K, --target C,
+// --report PATH, --bench-evals N, --trace PATH, --time-limit SECONDS,
+// --schedule geometric|lam, --auto-temperature, --candidates K,
+// --initial NAME); returns 0 on success. Without --seed a seed is taken from
+// the clock and printed to stderr so the run can be replayed. --threads 0
+// uses every online CPU; restarts default to one chain per thread and threads
+// default to one per replica. --format and --initial are interpreted by the
+// solver. Reports are JSON lines when PATH ends in .json or .jsonl and CSV
+// rows otherwise.
+int sa_parse_options(int argc, char **argv, sa_options *options);
+
+// Largest cost accepted from current_cost at this temperature (Metropolis
+// criterion with the uniform drawn up front: current - T * ln(u))
+double sa_threshold(sa_rng *rng, double current_cost, double temperature);
+
+// Anneal the solution held in state and return the best cost found
+double sa_run(const sa_problem *problem, void *state, const sa_params *params, sa_rng *rng, sa_stats *stats);
+
+// Run the chains requested by options and leave the best one in state.
+// With a single chain this is sa_run(); otherwise each extra chain anneals a
+// restarted copy of state on its own random stream split from rng, and a
+// summary of the final costs is printed. With replicas the copies instead
+// run at fixed temperatures on a geometric ladder between the schedule's
+// initial and final temperature, for as many moves as the schedule has, and
+// neighbouring temperatures try to exchange their solutions every
+// exchange_interval moves. Once one chain or replica reaches options->target
+// every chain stops, and restarts not yet begun are skipped.
+// With options->bench_evals the evaluators are timed on the starting solution
+// first, and with options->report a record of the run is appended to that file.
+// With options->trace every temperature step (every exchange round for
+// replicas) is recorded, see sa_trace.h. With options->time_limit the chains
+// cool from the initial to the final temperature over that many seconds of
+// wall-clock time instead of following the iteration count, and the best
+// solution found is kept when the budget runs out; chains beyond the thread
+// count share the budget, replicas exchange until it is spent. With
+// options->auto_temperature, or the Lam schedule, the initial temperature is
+// estimated from sampled moves and the final one is scaled with it; the
+// solver's own temperature is kept, with a note, when no sampled move goes
+// uphill. The Lam schedule adjusts the temperature after every move to
+// follow a target acceptance ratio over the run; replicas keep their fixed
+// ladder. With options->candidates K > 1 every step proposes K moves,
+// scores them with evaluate_batch() when the problem has it, and submits the
+// cheapest one to the acceptance test; each candidate counts as an
+// evaluation.
+double sa_solve(const sa_problem *problem, void *state, const sa_params *params,
+                const sa_options *options, sa_rng *rng, sa_stats *stats);
+
+#endif
@@ -0,0 +1,27 @@
+// Per-chain memory arena: one contiguous, cache-aligned block
+#include <stdlib.h>
+#include "sa_arena.h"
+
+int sa_arena_init(sa_arena *arena, size_t size) {
+    arena->size = sa_arena_size(size > 0 ? size : 1);
+    arena->used = 0;
+    arena->base = aligned_alloc(SA_ARENA_ALIGN, arena->size);
+    return arena->base != NULL ? 0 : -1;
+}
+
+void *sa_arena_alloc(sa_arena *arena, size_t size) {
+    size = sa_arena_size(size);
+    if (size > arena->size - arena->used) {
+        return NULL;
+    }
+    void *block = arena->base + arena->used;
+    arena->used += size;
+    return block;
+}
+
+void sa_arena_free(sa_arena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
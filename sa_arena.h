@@ -0,0 +1,34 @@
+// Per-chain memory arena: one contiguous, cache-aligned block
+#ifndef SA_ARENA_H
+#define SA_ARENA_H
+
+#include <stddef.h>
+
+// Alignment of the block and of every allocation in it
+#define SA_ARENA_ALIGN 64
+
+// A solver sizes the arena for all the buffers of one search state (current,
+// best and scratch), carves them out once when the state is created and
+// frees the whole block with the state, so nothing is allocated per move.
+typedef struct {
+    char *base;
+    size_t size;
+    size_t used;
+} sa_arena;
+
+// Bytes an allocation of size takes in an arena, padding included
+static inline size_t sa_arena_size(size_t size) {
+    return (size + SA_ARENA_ALIGN - 1) / SA_ARENA_ALIGN * SA_ARENA_ALIGN;
+}
+
+// Allocate a block of size bytes (the sum of sa_arena_size() of the buffers);
+// returns 0 on success
+int sa_arena_init(sa_arena *arena, size_t size);
+
+// Take an aligned, uninitialised buffer from the arena; NULL if it is full
+void *sa_arena_alloc(sa_arena *arena, size_t size);
+
+// Release the block and every buffer taken from it
+void sa_arena_free(sa_arena *arena);
+
+#endif
@@ -0,0 +1,66 @@
+// Batched evaluation of many candidate solutions at once
+#include <stddef.h>
+#include "sa_batch.h"
+
+// One clone of the kernel per instruction set, chosen when the program loads
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define BATCH_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define BATCH_CLONES
+#endif
+
+// The lane loops below have a fixed trip count and no dependence between
+// lanes, so the compiler turns each of them into vector instructions; built
+// without vectorisation they are the scalar fallback.
+BATCH_CLONES
+void sa_flowshop_batch(const sa_flowshop *instance, const int *sequences, int count, int first,
+                       const int *previous, double limit, int *makespans) {
+    int jobs = instance->jobs, stages = instance->machines;
+    for (int base = 0; base < count; base += SA_BATCH_LANES) {
+        // Sequence of each lane; lanes past the last candidate repeat it
+        const int *lane_sequence[SA_BATCH_LANES];
+        for (int l = 0; l < SA_BATCH_LANES; l++) {
+            int candidate = base + l < count ? base + l : count - 1;
+            lane_sequence[l] = &sequences[candidate * jobs];
+        }
+        // Completion times of the previous job at each stage, one column per lane
+        int completion[stages][SA_BATCH_LANES];
+        for (int j = 0; j < stages; j++) {
+            for (int l = 0; l < SA_BATCH_LANES; l++) {
+                completion[j][l] = previous != NULL ? previous[j] : 0;
+            }
+        }
+
+        for (int i = first; i < jobs; i++) {
+            // Offset of each lane's job in the processing times
+            int row[SA_BATCH_LANES];
+            for (int l = 0; l < SA_BATCH_LANES; l++) {
+                row[l] = lane_sequence[l][i] * stages;
+            }
+            int *done = completion[0];
+            for (int l = 0; l < SA_BATCH_LANES; l++) {
+                done[l] += instance->p[row[l]];
+            }
+            for (int j = 1; j < stages; j++) {
+                const int *times = &instance->p[j];
+                int *above = completion[j - 1], *stage = completion[j];
+                for (int l = 0; l < SA_BATCH_LANES; l++) {
+                    int ready = stage[l] > above[l] ? stage[l] : above[l];
+                    stage[l] = ready + times[row[l]];
+                }
+            }
+            // The makespans only grow, so stop once every lane is past the limit
+            int lowest = completion[stages - 1][0];
+            for (int l = 1; l < SA_BATCH_LANES; l++) {
+                lowest = completion[stages - 1][l] < lowest ? completion[stages - 1][l] : lowest;
+            }
+            if (lowest > limit) {
+                break;
+            }
+        }
+
+        for (int l = 0; l < SA_BATCH_LANES && base + l < count; l++) {
+            makespans[base + l] = completion[stages - 1][l];
+        }
+    }
+}
@@ -0,0 +1,23 @@
+// Batched evaluation of many candidate solutions at once
+#ifndef SA_BATCH_H
+#define SA_BATCH_H
+
+#include "sa_instance.h"
+
+// Candidates evaluated side by side, one per SIMD lane (8 fills an AVX2
+// register of ints, two AVX-512 halves or four SSE registers)
+#define SA_BATCH_LANES 8
+
+// Makespans of count flow shop sequences: sequences[c * jobs + i] is the i-th
+// job of candidate c. The candidates are evaluated SA_BATCH_LANES at a time,
+// structure-of-arrays, with the completion times of every lane at one stage
+// held in one vector. Positions before first are taken to be shared by all
+// candidates: previous holds the completion times of the job at position
+// first - 1 on each machine (NULL when first is 0). A group of lanes stops
+// once all of its makespans exceed limit, leaving values above it. The
+// kernel is compiled for AVX-512, AVX2 and the baseline instruction set and
+// the best one is picked at load time where the compiler supports it.
+void sa_flowshop_batch(const sa_flowshop *instance, const int *sequences, int count, int first,
+                       const int *previous, double limit, int *makespans);
+
+#endif
@@ -0,0 +1,88 @@
+// Constructive heuristics for the permutation flow shop
+#include <stdlib.h>
+#include <string.h>
+#include "sa_flowshop.h"
+
+typedef struct {
+    int job;
+    int total; // Processing time of the job over all machines
+} job_total;
+
+// Decreasing total, then increasing job index so the order is deterministic
+static int by_total(const void *a, const void *b) {
+    const job_total *x = a, *y = b;
+    if (x->total != y->total) {
+        return x->total < y->total ? 1 : -1;
+    }
+    return x->job - y->job;
+}
+
+int sa_flowshop_neh(const sa_flowshop *instance, int *sequence) {
+    int n = instance->jobs, m = instance->machines;
+    job_total *order = malloc(n * sizeof(job_total));
+    for (int j = 0; j < n; j++) {
+        order[j].job = j;
+        order[j].total = 0;
+        for (int k = 0; k < m; k++) {
+            order[j].total += instance->p[j * m + k];
+        }
+    }
+    qsort(order, n, sizeof(job_total), by_total);
+
+    // heads[i * m + k]: completion of the first i + 1 jobs on machine k;
+    // tails[i * m + k]: time from the start of job i on machine k to the end
+    int *heads = malloc(n * m * sizeof(int));
+    int *tails = malloc(n * m * sizeof(int));
+    int makespan = 0;
+    for (int length = 0; length < n; length++) {
+        for (int i = 0; i < length; i++) {
+            const int *times = &instance->p[sequence[i] * m];
+            for (int k = 0; k < m; k++) {
+                int above = i > 0 ? heads[(i - 1) * m + k] : 0;
+                int left = k > 0 ? heads[i * m + k - 1] : 0;
+                heads[i * m + k] = (above > left ? above : left) + times[k];
+            }
+        }
+        for (int i = length - 1; i >= 0; i--) {
+            const int *times = &instance->p[sequence[i] * m];
+            for (int k = m - 1; k >= 0; k--) {
+                int below = i < length - 1 ? tails[(i + 1) * m + k] : 0;
+                int right = k < m - 1 ? tails[i * m + k + 1] : 0;
+                tails[i * m + k] = (below > right ? below : right) + times[k];
+            }
+        }
+        // Inserting at position i finishes the job on machine k at
+        // max(heads[i - 1][k], finish on machine k - 1) + p[k]
+        const int *job = &instance->p[order[length].job * m];
+        int best = 0;
+        for (int i = 0; i <= length; i++) {
+            int finish = 0, span = 0;
+            for (int k = 0; k < m; k++) {
+                int above = i > 0 ? heads[(i - 1) * m + k] : 0;
+                finish = (above > finish ? above : finish) + job[k];
+                int end = finish + (i < length ? tails[i * m + k] : 0);
+                if (end > span) {
+                    span = end;
+                }
+            }
+            if (i == 0 || span < makespan) {
+                best = i;
+                makespan = span;
+            }
+        }
+        memmove(&sequence[best + 1], &sequence[best], (length - best) * sizeof(int));
+        sequence[best] = order[length].job;
+    }
+    free(tails);
+    free(heads);
+    free(order);
+    return makespan;
+}
+
+double sa_flowshop_temperature(const sa_flowshop *instance) {
+    long total = 0;
+    for (int i = 0; i < instance->jobs * instance->machines; i++) {
+        total += instance->p[i];
+    }
+    return 0.4 * total / (10.0 * instance->jobs * instance->machines);
+}
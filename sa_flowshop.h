@@ -0,0 +1,20 @@
+// Constructive heuristics for the permutation flow shop
+#ifndef SA_FLOWSHOP_H
+#define SA_FLOWSHOP_H
+
+#include "sa_instance.h"
+
+// NEH (Nawaz, Enscore and Ham, 1983): take the jobs by decreasing total
+// processing time and insert each one at the position of the partial
+// sequence that gives the lowest makespan, the first such position on ties.
+// Every insertion position of a job is costed at once from the heads and
+// tails of the partial sequence (Taillard, 1990), so the whole construction
+// takes O(n^2 m). Writes the n jobs to sequence and returns its makespan.
+int sa_flowshop_neh(const sa_flowshop *instance, int *sequence);
+
+// Annealing temperature suited to a solution as good as NEH's:
+// 0.4 * total processing time / (10 * jobs * machines), the constant
+// temperature of the iterated greedy algorithm (Ruiz and Stuetzle, 2007)
+double sa_flowshop_temperature(const sa_flowshop *instance);
+
+#endif
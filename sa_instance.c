@@ -0,0 +1,907 @@
+// Benchmark instance loaders for the scheduling problems
+#define _GNU_SOURCE // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sa_instance.h"
+
+#define MAX_SIZE (1 << 20) // Largest count accepted for jobs, machines, ...
+
+// Read-only view of a mapped file; numbers are parsed where they lie
+typedef struct {
+    const char *path;
+    const char *data;
+    const char *pos;
+    const char *end;
+} reader;
+
+static int reader_open(reader *r, const char *path) {
+    r->path = path;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "%s: empty or unreadable file\n", path);
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    r->data = data;
+    r->pos = data;
+    r->end = r->data + st.st_size;
+    return 0;
+}
+
+static void reader_close(reader *r) {
+    munmap((void *)r->data, r->end - r->data);
+}
+
+// Report an error at the current position
+static int reader_error(const reader *r, const char *message, const char *detail) {
+    int line = 1;
+    for (const char *p = r->data; p < r->pos; p++) {
+        if (*p == '\n') {
+            line++;
+        }
+    }
+    fprintf(stderr, "%s:%d: %s%s\n", r->path, line, message, detail);
+    return -1;
+}
+
+// Parse the next integer, skipping white space
+static int read_int(reader *r, int *value) {
+    const char *p = r->pos;
+    while (p < r->end && isspace((unsigned char)*p)) {
+        p++;
+    }
+    int negative = 0;
+    if (p < r->end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    r->pos = p;
+    if (p >= r->end || !isdigit((unsigned char)*p)) {
+        return reader_error(r, p >= r->end ? "unexpected end of file" : "expected an integer", "");
+    }
+    long parsed = 0;
+    while (p < r->end && isdigit((unsigned char)*p)) {
+        parsed = parsed * 10 + (*p++ - '0');
+        if (parsed > INT_MAX) {
+            return reader_error(r, "integer out of range", "");
+        }
+    }
+    r->pos = p;
+    *value = negative ? (int)-parsed : (int)parsed;
+    return 0;
+}
+
+// Parse the next integer and check that it lies in [min, max]
+static int read_range(reader *r, int *value, int min, int max, const char *what) {
+    if (read_int(r, value) != 0) {
+        return -1;
+    }
+    if (*value < min || *value > max) {
+        return reader_error(r, "invalid ", what);
+    }
+    return 0;
+}
+
+static void skip_line(reader *r) {
+    const char *newline = memchr(r->pos, '\n', r->end - r->pos);
+    r->pos = newline != NULL ? newline + 1 : r->end;
+}
+
+// Skip blank lines and lines that do not start with a number (titles, comments)
+static void skip_text_lines(reader *r) {
+    while (r->pos < r->end) {
+        const char *p = r->pos;
+        while (p < r->end && isspace((unsigned char)*p)) {
+            p++;
+        }
+        const char *digit = p < r->end && (*p == '-' || *p == '+') ? p + 1 : p;
+        if (digit < r->end && isdigit((unsigned char)*digit)) {
+            return;
+        }
+        r->pos = p;
+        if (p < r->end) {
+            skip_line(r);
+        }
+    }
+}
+
+// Move past the next occurrence of text
+static int skip_past(reader *r, const char *text) {
+    size_t length = strlen(text);
+    const char *found = memmem(r->pos, r->end - r->pos, text, length);
+    if (found == NULL) {
+        return reader_error(r, "missing ", text);
+    }
+    r->pos = found + length;
+    return 0;
+}
+
+// Move past the instances before the index-th (from 1) of a file that holds
+// several. Each starts with its numbers of jobs and machines, then the rest
+// of the header line in Taillard's layout, and holds values_per_cell numbers
+// per job and machine; lines of text between them are skipped.
+static int skip_instances(reader *r, int index, int taillard, int values_per_cell) {
+    if (index < 1) {
+        fprintf(stderr, "%s: instance index must be at least 1\n", r->path);
+        return -1;
+    }
+    for (int i = 1; i < index; i++) {
+        int n, m;
+        skip_text_lines(r);
+        if (r->pos == r->end) {
+            fprintf(stderr, "%s: only %d instance%s in the file\n", r->path, i - 1, i == 2 ? "" : "s");
+            return -1;
+        }
+        if (read_range(r, &n, 1, MAX_SIZE, "number of jobs") != 0 ||
+            read_range(r, &m, 1, MAX_SIZE / n, "number of machines") != 0) {
+            return -1;
+        }
+        if (taillard) {
+            skip_line(r);
+        }
+        for (long v = 0; v < (long)values_per_cell * n * m; v++) {
+            int skipped;
+            skip_text_lines(r);
+            if (read_int(r, &skipped) != 0) {
+                return -1;
+            }
+        }
+    }
+    skip_text_lines(r);
+    if (r->pos == r->end) {
+        fprintf(stderr, "%s: only %d instance%s in the file\n", r->path, index - 1, index == 2 ? "" : "s");
+        return -1;
+    }
+    return 0;
+}
+
+// Check the index of a format that holds one instance per file
+static int single_instance(const char *path, int index) {
+    if (index < 1) {
+        fprintf(stderr, "%s: instance index must be at least 1\n", path);
+        return -1;
+    }
+    if (index > 1) {
+        fprintf(stderr, "%s: only 1 instance in the file\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int unknown_format(const char *path, const char *format) {
+    fprintf(stderr, "%s: unknown instance format '%s'\n", path, format);
+    return -1;
+}
+
+// Check the requested format; NULL selects the first (default) one
+static int format_is(const char *format, const char *name, int is_default) {
+    return format == NULL ? is_default : strcmp(format, name) == 0;
+}
+
+// Growable array of ints for lists whose total length is only known at the end
+typedef struct {
+    int *data;
+    int count;
+    int capacity;
+} int_list;
+
+static void int_list_push(int_list *list, int value) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity > 0 ? 2 * list->capacity : 64;
+        list->data = realloc(list->data, list->capacity * sizeof(int));
+    }
+    list->data[list->count++] = value;
+}
+
+int sa_load_flowshop(const char *path, const char *format, int index, sa_flowshop *instance) {
+    int taillard = format_is(format, "taillard", 1);
+    if (!taillard && !format_is(format, "orlib", 0)) {
+        return unknown_format(path, format);
+    }
+    reader r;
+    if (reader_open(&r, path) != 0) {
+        return -1;
+    }
+    int n, m;
+    instance->p = NULL;
+    if (skip_instances(&r, index, taillard, taillard ? 1 : 2) != 0) {
+        goto fail;
+    }
+    if (read_range(&r, &n, 1, MAX_SIZE, "number of jobs") != 0 ||
+        read_range(&r, &m, 1, MAX_SIZE / n, "number of machines") != 0) {
+        goto fail;
+    }
+    instance->jobs = n;
+    instance->machines = m;
+    instance->p = malloc((size_t)n * m * sizeof(int));
+    if (taillard) {
+        // Rest of the header line (seed, bounds), then one row per machine
+        skip_line(&r);
+        for (int k = 0; k < m; k++) {
+            skip_text_lines(&r);
+            for (int j = 0; j < n; j++) {
+                if (read_range(&r, &instance->p[j * m + k], 0, INT_MAX, "processing time") != 0) {
+                    goto fail;
+                }
+            }
+        }
+    } else {
+        for (int j = 0; j < n * m; j++) {
+            instance->p[j] = 0;
+        }
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < m; k++) {
+                int machine, time;
+                if (read_range(&r, &machine, 0, m - 1, "machine") != 0 ||
+                    read_range(&r, &time, 0, INT_MAX, "processing time") != 0) {
+                    goto fail;
+                }
+                instance->p[j * m + machine] = time;
+            }
+        }
+    }
+    reader_close(&r);
+    return 0;
+fail:
+    reader_close(&r);
+    sa_free_flowshop(instance);
+    return -1;
+}
+
+void sa_free_flowshop(sa_flowshop *instance) {
+    free(instance->p);
+    instance->p = NULL;
+}
+
+// Read a job shop in Taillard's or the OR-Library layout
+static int read_jobshop(reader *r, int taillard, sa_jobshop *instance) {
+    int n, m;
+    instance->machine = NULL;
+    instance->time = NULL;
+    skip_text_lines(r);
+    if (read_range(r, &n, 1, MAX_SIZE, "number of jobs") != 0 ||
+        read_range(r, &m, 1, MAX_SIZE / n, "number of machines") != 0) {
+        return -1;
+    }
+    instance->jobs = n;
+    instance->machines = m;
+    instance->machine = malloc((size_t)n * m * sizeof(int));
+    instance->time = malloc((size_t)n * m * sizeof(int));
+    if (taillard) {
+        // "Times" section, then "Machines" section with 1-based machines
+        skip_line(r);
+        skip_text_lines(r);
+        for (int i = 0; i < n * m; i++) {
+            if (read_range(r, &instance->time[i], 0, INT_MAX, "processing time") != 0) {
+                return -1;
+            }
+        }
+        skip_text_lines(r);
+        for (int i = 0; i < n * m; i++) {
+            if (read_range(r, &instance->machine[i], 1, m, "machine") != 0) {
+                return -1;
+            }
+            instance->machine[i]--;
+        }
+    } else {
+        for (int i = 0; i < n * m; i++) {
+            if (read_range(r, &instance->machine[i], 0, m - 1, "machine") != 0 ||
+                read_range(r, &instance->time[i], 0, INT_MAX, "processing time") != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int sa_load_jobshop(const char *path, const char *format, int index, sa_jobshop *instance) {
+    int taillard = format_is(format, "taillard", 1);
+    if (!taillard && !format_is(format, "orlib", 0)) {
+        return unknown_format(path, format);
+    }
+    reader r;
+    if (reader_open(&r, path) != 0) {
+        return -1;
+    }
+    instance->machine = NULL;
+    instance->time = NULL;
+    int status = skip_instances(&r, index, taillard, 2);
+    if (status == 0) {
+        status = read_jobshop(&r, taillard, instance);
+    }
+    reader_close(&r);
+    if (status != 0) {
+        sa_free_jobshop(instance);
+    }
+    return status;
+}
+
+void sa_free_jobshop(sa_jobshop *instance) {
+    free(instance->machine);
+    free(instance->time);
+    instance->machine = NULL;
+    instance->time = NULL;
+}
+
+int sa_load_setup_jobshop(const char *path, const char *format, int index, sa_setup_jobshop *instance) {
+    if (!format_is(format, "sdst", 1)) {
+        return unknown_format(path, format);
+    }
+    if (single_instance(path, index) != 0) {
+        return -1;
+    }
+    reader r;
+    if (reader_open(&r, path) != 0) {
+        return -1;
+    }
+    instance->setup = NULL;
+    if (read_jobshop(&r, 0, &instance->shop) != 0) {
+        goto fail;
+    }
+    int n = instance->shop.jobs, m = instance->shop.machines;
+    instance->stride = (n + SA_SETUP_ALIGN - 1) / SA_SETUP_ALIGN * SA_SETUP_ALIGN;
+    size_t entries = (size_t)m * n * instance->stride;
+    instance->setup = aligned_alloc(64, entries * sizeof(int16_t));
+    memset(instance->setup, 0, entries * sizeof(int16_t));
+    for (int k = 0; k < m; k++) {
+        skip_text_lines(&r);
+        for (int a = 0; a < n; a++) {
+            int16_t *row = &instance->setup[((size_t)k * n + a) * instance->stride];
+            for (int b = 0; b < n; b++) {
+                int value;
+                if (read_range(&r, &value, 0, INT16_MAX, "setup time") != 0) {
+                    goto fail;
+                }
+                row[b] = (int16_t)value;
+            }
+        }
+    }
+    reader_close(&r);
+    return 0;
+fail:
+    reader_close(&r);
+    sa_free_setup_jobshop(instance);
+    return -1;
+}
+
+void sa_free_setup_jobshop(sa_setup_jobshop *instance) {
+    sa_free_jobshop(&instance->shop);
+    free(instance->setup);
+    instance->setup = NULL;
+}
+
+int sa_load_timelag_jobshop(const char *path, const char *format, int index, sa_timelag_jobshop *instance) {
+    if (!format_is(format, "timelag", 1)) {
+        return unknown_format(path, format);
+    }
+    if (single_instance(path, index) != 0) {
+        return -1;
+    }
+    reader r;
+    if (reader_open(&r, path) != 0) {
+        return -1;
+    }
+    instance->min_lag = NULL;
+    instance->max_lag = NULL;
+    if (read_jobshop(&r, 0, &instance->shop) != 0) {
+        goto fail;
+    }
+    int n = instance->shop.jobs, m = instance->shop.machines;
+    instance->min_lag = malloc((size_t)n * m * sizeof(int));
+    instance->max_lag = malloc((size_t)n * m * sizeof(int));
+    skip_text_lines(&r);
+    for (int j = 0; j < n; j++) {
+        for (int k = 0; k < m - 1; k++) {
+            int *low = &instance->min_lag[j * m + k], *high = &instance->max_lag[j * m + k];
+            if (read_range(&r, low, 0, INT_MAX, "minimum time lag") != 0 ||
+                read_range(&r, high, -1, INT_MAX, "maximum time lag") != 0) {
+                goto fail;
+            }
+            if (*high >= 0 && *high < *low) {
+                reader_error(&r, "maximum time lag below the minimum", "");
+                goto fail;
+            }
+        }
+        instance->min_lag[j * m + m - 1] = 0;
+        instance->max_lag[j * m + m - 1] = -1;
+    }
+    reader_close(&r);
+    return 0;
+fail:
+    reader_close(&r);
+    sa_free_timelag_jobshop(instance);
+    return -1;
+}
+
+void sa_free_timelag_jobshop(sa_timelag_jobshop *instance) {
+    sa_free_jobshop(&instance->shop);
+    free(instance->min_lag);
+    free(instance->max_lag);
+    instance->min_lag = NULL;
+    instance->max_lag = NULL;
+}
+
+int sa_load_single_machine(const char *path, const char *format, int index, sa_single_machine *instance) {
+    int n;
+    if (format_is(format, "wt40", 1)) {
+        n = 40;
+    } else if (format_is(format, "wt50", 0)) {
+        n = 50;
+    } else if (format_is(format, "wt100", 0)) {
+        n = 100;
+    } else {
+        return unknown_format(path, format);
+    }
+    if (index < 1) {
+        fprintf(stderr, "%s: instance index must be at least 1\n", path);
+        return -1;
+    }
+    reader r;
+    if (reader_open(&r, path) != 0) {
+        return -1;
+    }
+    instance->jobs = n;
+    instance->p = malloc(n * sizeof(int));
+    instance->w = malloc(n * sizeof(int));
+    instance->d = malloc(n * sizeof(int));
+    // Skip the earlier instances of the file
+    for (long i = 0; i < (long)(index - 1) * 3 * n; i++) {
+        int skipped;
+        if (read_int(&r, &skipped) != 0) {
+            goto fail;
+        }
+    }
+    int *columns[3] = {instance->p, instance->w, instance->d};
+    for (int c = 0; c < 3; c++) {
+        for (int j = 0; j < n; j++) {
+            if (read_range(&r, &columns[c][j], 0, INT_MAX, "job data") != 0) {
+                goto fail;
+            }
+        }
+    }
+    reader_close(&r);
+    return 0;
+fail:
+    reader_close(&r);
+    sa_free_single_machine(instance);
+    return -1;
+}
+
+void sa_free_single_machine(sa_single_machine *instance) {
+    free(instance->p);
+    free(instance->w);
+    free(instance->d);
+    instance->p = NULL;
+    instance->w = NULL;
+    instance->d = NULL;
+}
+
+// Check that the precedence arcs form no cycle: Kahn's topological sort
+// must reach every activity
+static int precedence_acyclic(int n, const int *successor_start, const int *successors) {
+    int *predecessors = calloc(n, sizeof(int)), *ready = malloc(n * sizeof(int));
+    int count = 0, reached = 0;
+    for (int i = 0; i < successor_start[n]; i++) {
+        predecessors[successors[i]]++;
+    }
+    for (int a = 0; a < n; a++) {
+        if (predecessors[a] == 0) {
+            ready[count++] = a;
+        }
+    }
+    while (count > 0) {
+        int a = ready[--count];
+        reached++;
+        for (int i = successor_start[a]; i < successor_start[a + 1]; i++) {
+            if (--predecessors[successors[i]] == 0) {
+                ready[count++] = successors[i];
+            }
+        }
+    }
+    free(predecessors);
+    free(ready);
+    return reached == n;
+}
+
+// One PSPLIB project, single mode (.sm) or multi-mode (.mm)
+static int read_psplib(reader *r, sa_project *instance) {
+    int n, resources, nonrenewables;
+    int_list successors = {NULL, 0, 0};
+    memset(instance, 0, sizeof(*instance));
+    if (skip_past(r, "jobs (incl. supersource/sink )") != 0 || skip_past(r, ":") != 0 ||
+        read_range(r, &n, 2, MAX_SIZE, "number of jobs") != 0 ||
+        skip_past(r, "- renewable") != 0 || skip_past(r, ":") != 0 ||
+        read_range(r, &resources, 0, MAX_SIZE / n, "number of resources") != 0 ||
+        skip_past(r, "- nonrenewable") != 0 || skip_past(r, ":") != 0 ||
+        read_range(r, &nonrenewables, 0, MAX_SIZE / n, "number of nonrenewable resources") != 0) {
+        goto fail;
+    }
+    instance->activities = n;
+    instance->resources = resources;
+    instance->nonrenewables = nonrenewables;
+    instance->capacity = malloc((resources + 1) * sizeof(int));
+    instance->budget = malloc((nonrenewables + 1) * sizeof(int));
+    instance->mode_start = malloc((n + 1) * sizeof(int));
+    instance->successor_start = malloc((n + 1) * sizeof(int));
+    instance->projects = 1;
+    instance->project_start = malloc(2 * sizeof(int));
+    instance->project_start[0] = 0;
+    instance->project_start[1] = n;
+
+    // jobnr. #modes #successors successors...
+    if (skip_past(r, "PRECEDENCE RELATIONS:") != 0) {
+        goto fail;
+    }
+    skip_line(r);
+    skip_line(r);
+    instance->mode_start[0] = 0;
+    for (int a = 0; a < n; a++) {
+        int job, modes, count;
+        if (read_range(r, &job, a + 1, a + 1, "job number") != 0 ||
+            read_range(r, &modes, 1, MAX_SIZE - instance->mode_start[a], "number of modes") != 0 ||
+            read_range(r, &count, 0, n - 1, "number of successors") != 0) {
+            goto fail;
+        }
+        instance->mode_start[a + 1] = instance->mode_start[a] + modes;
+        instance->successor_start[a] = successors.count;
+        for (int s = 0; s < count; s++) {
+            int successor;
+            if (read_range(r, &successor, 1, n, "successor") != 0) {
+                goto fail;
+            }
+            int_list_push(&successors, successor - 1);
+        }
+    }
+    instance->successor_start[n] = successors.count;
+    instance->successors = successors.data != NULL ? successors.data : malloc(sizeof(int));
+    successors.data = NULL;
+    if (!precedence_acyclic(n, instance->successor_start, instance->successors)) {
+        reader_error(r, "cyclic precedence relations", "");
+        goto fail;
+    }
+    int modes = instance->mode_start[n];
+    if (resources > MAX_SIZE / modes || nonrenewables > MAX_SIZE / modes) {
+        reader_error(r, "too many modes and resources", "");
+        goto fail;
+    }
+    instance->duration = malloc(modes * sizeof(int));
+    instance->request = malloc(((size_t)modes * resources + 1) * sizeof(int));
+    instance->consumption = malloc(((size_t)modes * nonrenewables + 1) * sizeof(int));
+
+    // jobnr. mode duration R1 ... Rk N1 ... Nl, below a line of dashes; the
+    // lines of the other modes of a job leave out the job number
+    if (skip_past(r, "REQUESTS/DURATIONS:") != 0 || skip_past(r, "---") != 0) {
+        goto fail;
+    }
+    skip_line(r);
+    for (int a = 0; a < n; a++) {
+        int job;
+        if (read_range(r, &job, a + 1, a + 1, "job number") != 0) {
+            goto fail;
+        }
+        for (int m = instance->mode_start[a]; m < instance->mode_start[a + 1]; m++) {
+            int mode, first = instance->mode_start[a];
+            if (read_range(r, &mode, m - first + 1, m - first + 1, "mode") != 0 ||
+                read_range(r, &instance->duration[m], 0, INT_MAX, "duration") != 0) {
+                goto fail;
+            }
+            for (int k = 0; k < resources; k++) {
+                if (read_range(r, &instance->request[m * resources + k], 0, INT_MAX, "resource request") != 0) {
+                    goto fail;
+                }
+            }
+            for (int k = 0; k < nonrenewables; k++) {
+                if (read_range(r, &instance->consumption[m * nonrenewables + k], 0, INT_MAX,
+                               "nonrenewable resource request") != 0) {
+                    goto fail;
+                }
+            }
+        }
+    }
+
+    // Header line "R 1  R 2 ... N 1 ...", then the capacities and budgets
+    if (skip_past(r, "RESOURCEAVAILABILITIES:") != 0) {
+        goto fail;
+    }
+    skip_line(r);
+    skip_line(r);
+    for (int k = 0; k < resources; k++) {
+        if (read_range(r, &instance->capacity[k], 0, INT_MAX, "resource capacity") != 0) {
+            goto fail;
+        }
+    }
+    for (int k = 0; k < nonrenewables; k++) {
+        if (read_range(r, &instance->budget[k], 0, INT_MAX, "nonrenewable resource capacity") != 0) {
+            goto fail;
+        }
+    }
+    return 0;
+fail:
+    free(successors.data);
+    sa_free_project(instance);
+    return -1;
+}
+
+// Path of a file named in the list file at path: as given when absolute,
+// otherwise relative to the directory of the list
+static char *sibling_path(const char *path, const char *name, size_t length) {
+    const char *slash = strrchr(path, '/');
+    size_t directory = name[0] != '/' && slash != NULL ? (size_t)(slash - path + 1) : 0;
+    char *joined = malloc(directory + length + 1);
+    memcpy(joined, path, directory);
+    memcpy(joined + directory, name, length);
+    joined[directory + length] = '\0';
+    return joined;
+}
+
+// Join the projects of a portfolio into one instance: the activities one
+// project after another, the renewable resources shared and each project
+// keeping its own nonrenewable resources
+static void merge_projects(const sa_project *parts, int count, sa_project *instance) {
+    int n = 0, modes = 0, nonrenewables = 0, arcs = 0, resources = instance->resources;
+    for (int p = 0; p < count; p++) {
+        n += parts[p].activities;
+        modes += parts[p].mode_start[parts[p].activities];
+        nonrenewables += parts[p].nonrenewables;
+        arcs += parts[p].successor_start[parts[p].activities];
+    }
+    instance->activities = n;
+    instance->nonrenewables = nonrenewables;
+    instance->projects = count;
+    instance->project_start = malloc((count + 1) * sizeof(int));
+    instance->mode_start = malloc((n + 1) * sizeof(int));
+    instance->successor_start = malloc((n + 1) * sizeof(int));
+    instance->successors = malloc((arcs + 1) * sizeof(int));
+    instance->duration = malloc((modes + 1) * sizeof(int));
+    instance->request = malloc(((size_t)modes * resources + 1) * sizeof(int));
+    instance->consumption = calloc((size_t)modes * nonrenewables + 1, sizeof(int));
+    instance->budget = malloc((nonrenewables + 1) * sizeof(int));
+    int a = 0, m = 0, k = 0, s = 0;
+    for (int p = 0; p < count; p++) {
+        const sa_project *part = &parts[p];
+        int part_modes = part->mode_start[part->activities];
+        instance->project_start[p] = a;
+        for (int i = 0; i < part->activities; i++) {
+            instance->mode_start[a + i] = m + part->mode_start[i];
+            instance->successor_start[a + i] = s + part->successor_start[i];
+        }
+        for (int i = 0; i < part->successor_start[part->activities]; i++) {
+            instance->successors[s + i] = a + part->successors[i];
+        }
+        memcpy(&instance->duration[m], part->duration, part_modes * sizeof(int));
+        memcpy(&instance->request[(size_t)m * resources], part->request, (size_t)part_modes * resources * sizeof(int));
+        for (int i = 0; i < part_modes; i++) {
+            memcpy(&instance->consumption[(size_t)(m + i) * nonrenewables + k],
+                   &part->consumption[(size_t)i * part->nonrenewables], part->nonrenewables * sizeof(int));
+        }
+        memcpy(&instance->budget[k], part->budget, part->nonrenewables * sizeof(int));
+        a += part->activities;
+        m += part_modes;
+        k += part->nonrenewables;
+        s += part->successor_start[part->activities];
+    }
+    instance->project_start[count] = n;
+    instance->mode_start[n] = m;
+    instance->successor_start[n] = s;
+}
+
+// Portfolio: number of projects and of renewable resources, the capacities
+// of the shared resources, then the PSPLIB file of each project
+static int read_portfolio(reader *r, sa_project *instance) {
+    int count, resources;
+    memset(instance, 0, sizeof(*instance));
+    skip_text_lines(r);
+    if (read_range(r, &count, 1, MAX_SIZE, "number of projects") != 0 ||
+        read_range(r, &resources, 0, MAX_SIZE, "number of resources") != 0) {
+        return -1;
+    }
+    instance->resources = resources;
+    instance->capacity = malloc((resources + 1) * sizeof(int));
+    for (int k = 0; k < resources; k++) {
+        if (read_range(r, &instance->capacity[k], 0, INT_MAX, "resource capacity") != 0) {
+            sa_free_project(instance);
+            return -1;
+        }
+    }
+    sa_project *parts = calloc(count, sizeof(sa_project));
+    int loaded = 0, status = 0, activities = 0;
+    for (; loaded < count && status == 0; loaded++) {
+        while (r->pos < r->end && isspace((unsigned char)*r->pos)) {
+            r->pos++;
+        }
+        const char *name = r->pos;
+        while (r->pos < r->end && !isspace((unsigned char)*r->pos)) {
+            r->pos++;
+        }
+        if (r->pos == name) {
+            status = reader_error(r, "unexpected end of file", "");
+            break;
+        }
+        char *file = sibling_path(r->path, name, r->pos - name);
+        status = sa_load_project(file, "psplib", 1, &parts[loaded]);
+        free(file);
+        if (status == 0 && parts[loaded].resources != resources) {
+            status = reader_error(r, "project with a different number of resources", "");
+        }
+        activities += status == 0 ? parts[loaded].activities : 0;
+        if (status == 0 && activities > MAX_SIZE) {
+            status = reader_error(r, "too many activities", "");
+        }
+    }
+    if (status == 0) {
+        merge_projects(parts, count, instance);
+    } else {
+        sa_free_project(instance);
+    }
+    for (int p = 0; p < loaded; p++) {
+        sa_free_project(&parts[p]);
+    }
+    free(parts);
+    return status;
+}
+
+int sa_load_project(const char *path, const char *format, int index, sa_project *instance) {
+    int portfolio = format_is(format, "portfolio", 0);
+    if (!portfolio && !format_is(format, "psplib", 1)) {
+        return unknown_format(path, format);
+    }
+    if (single_instance(path, index) != 0) {
+        return -1;
+    }
+    reader r;
+    if (reader_open(&r, path) != 0) {
+        return -1;
+    }
+    int status = portfolio ? read_portfolio(&r, instance) : read_psplib(&r, instance);
+    reader_close(&r);
+    return status;
+}
+
+void sa_free_project(sa_project *instance) {
+    free(instance->mode_start);
+    free(instance->duration);
+    free(instance->request);
+    free(instance->consumption);
+    free(instance->capacity);
+    free(instance->budget);
+    free(instance->successor_start);
+    free(instance->successors);
+    free(instance->project_start);
+    memset(instance, 0, sizeof(*instance));
+}
+
+int sa_load_flexible_jobshop(const char *path, const char *format, int index, sa_flexible_jobshop *instance) {
+    if (!format_is(format, "brandimarte", 1)) {
+        return unknown_format(path, format);
+    }
+    if (single_instance(path, index) != 0) {
+        return -1;
+    }
+    reader r;
+    if (reader_open(&r, path) != 0) {
+        return -1;
+    }
+    int n, m;
+    int_list option_start = {NULL, 0, 0}, option_machine = {NULL, 0, 0}, option_time = {NULL, 0, 0};
+    memset(instance, 0, sizeof(*instance));
+    skip_text_lines(&r);
+    if (read_range(&r, &n, 1, MAX_SIZE, "number of jobs") != 0 ||
+        read_range(&r, &m, 1, MAX_SIZE, "number of machines") != 0) {
+        goto fail;
+    }
+    // The rest of the first line is the average number of machines per operation
+    skip_line(&r);
+    instance->jobs = n;
+    instance->machines = m;
+    instance->job_start = malloc((n + 1) * sizeof(int));
+    for (int j = 0; j < n; j++) {
+        int operations;
+        instance->job_start[j] = option_start.count;
+        if (read_range(&r, &operations, 1, MAX_SIZE, "number of operations") != 0) {
+            goto fail;
+        }
+        for (int o = 0; o < operations; o++) {
+            int options;
+            int_list_push(&option_start, option_machine.count);
+            if (read_range(&r, &options, 1, m, "number of machines") != 0) {
+                goto fail;
+            }
+            for (int i = 0; i < options; i++) {
+                int machine, time;
+                if (read_range(&r, &machine, 1, m, "machine") != 0 ||
+                    read_range(&r, &time, 0, INT_MAX, "processing time") != 0) {
+                    goto fail;
+                }
+                int_list_push(&option_machine, machine - 1);
+                int_list_push(&option_time, time);
+            }
+        }
+    }
+    instance->job_start[n] = option_start.count;
+    instance->operations = option_start.count;
+    int_list_push(&option_start, option_machine.count);
+    instance->option_start = option_start.data;
+    instance->option_machine = option_machine.data;
+    instance->option_time = option_time.data;
+    reader_close(&r);
+    return 0;
+fail:
+    reader_close(&r);
+    free(option_start.data);
+    free(option_machine.data);
+    free(option_time.data);
+    sa_free_flexible_jobshop(instance);
+    return -1;
+}
+
+void sa_free_flexible_jobshop(sa_flexible_jobshop *instance) {
+    free(instance->job_start);
+    free(instance->option_start);
+    free(instance->option_machine);
+    free(instance->option_time);
+    memset(instance, 0, sizeof(*instance));
+}
+
+int sa_load_sequencing(const char *path, const char *format, int index, sa_sequencing *instance) {
+    if (!format_is(format, "tsplib", 1)) {
+        return unknown_format(path, format);
+    }
+    if (single_instance(path, index) != 0) {
+        return -1;
+    }
+    reader r;
+    if (reader_open(&r, path) != 0) {
+        return -1;
+    }
+    int n, first;
+    instance->cost = NULL;
+    if (skip_past(&r, "DIMENSION") != 0 || skip_past(&r, ":") != 0 ||
+        read_range(&r, &n, 1, 1 << 15, "dimension") != 0 ||
+        skip_past(&r, "EDGE_WEIGHT_SECTION") != 0 || read_int(&r, &first) != 0) {
+        goto fail;
+    }
+    instance->n = n;
+    instance->cost = malloc((size_t)n * n * sizeof(int));
+    // SOP files repeat the dimension before the matrix; cost[0][0] is always 0
+    int i = 0;
+    if (first != n) {
+        instance->cost[i++] = first;
+    }
+    for (; i < n * n; i++) {
+        if (read_range(&r, &instance->cost[i], -1, INT_MAX, "cost") != 0) {
+            goto fail;
+        }
+    }
+    reader_close(&r);
+    return 0;
+fail:
+    reader_close(&r);
+    sa_free_sequencing(instance);
+    return -1;
+}
+
+void sa_free_sequencing(sa_sequencing *instance) {
+    free(instance->cost);
+    instance->cost = NULL;
+}
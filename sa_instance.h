@@ -0,0 +1,148 @@
+// Benchmark instance loaders for the scheduling problems
+#ifndef SA_INSTANCE_H
+#define SA_INSTANCE_H
+
+#include <stdint.h>
+
+// All loaders map the file read-only and parse numbers in place. They return
+// 0 on success; on failure they print "path:line: message" to stderr and
+// return -1. Arrays are sized to the instance and released with the
+// matching sa_free_* function.
+
+// Permutation flow shop and job shop files may hold several instances one
+// after another; index picks one, counted from 1. The other formats hold one
+// instance per file, and any index but 1 is rejected.
+
+// Permutation flow shop: p[j * machines + k] is the time of job j on machine k
+// Formats: "taillard" (n m [seed ub lb], then one row of n times per machine)
+//          "orlib"    (n m, then one row of m "machine time" pairs per job)
+typedef struct {
+    int jobs;
+    int machines;
+    int *p;
+} sa_flowshop;
+
+int sa_load_flowshop(const char *path, const char *format, int index, sa_flowshop *instance);
+void sa_free_flowshop(sa_flowshop *instance);
+
+// Job shop: operation k of job j runs on machine[j * machines + k] (0-based)
+// for time[j * machines + k]
+// Formats: "taillard" (n m [seed ub lb], Times: n rows, Machines: n rows, 1-based)
+//          "orlib"    (n m, then one row of m "machine time" pairs per job, 0-based)
+typedef struct {
+    int jobs;
+    int machines;
+    int *machine;
+    int *time;
+} sa_jobshop;
+
+int sa_load_jobshop(const char *path, const char *format, int index, sa_jobshop *instance);
+void sa_free_jobshop(sa_jobshop *instance);
+
+// Job shop with sequence-dependent setup times: the job shop in the "orlib"
+// layout, then one jobs x jobs matrix per machine. Setups are stored dense as
+// 16-bit values: setup[(k * jobs + a) * stride + b] is the setup on machine k
+// between job a and a following job b. Rows are padded to stride entries, a
+// multiple of SA_SETUP_ALIGN, so each row starts on a 64-byte line.
+// Format: "sdst"
+#define SA_SETUP_ALIGN 32
+typedef struct {
+    sa_jobshop shop;
+    int stride;
+    int16_t *setup;
+} sa_setup_jobshop;
+
+int sa_load_setup_jobshop(const char *path, const char *format, int index, sa_setup_jobshop *instance);
+void sa_free_setup_jobshop(sa_setup_jobshop *instance);
+
+// Job shop with time lags: the job shop in the "orlib" layout, then one row
+// per job of m - 1 "min max" pairs. Operation k + 1 of job j starts at least
+// min_lag[j * machines + k] and at most max_lag[j * machines + k] after
+// operation k ends; a maximum of -1 leaves it unbounded. The last entry of
+// each job is unused (0 and -1).
+// Format: "timelag"
+typedef struct {
+    sa_jobshop shop;
+    int *min_lag;
+    int *max_lag;
+} sa_timelag_jobshop;
+
+int sa_load_timelag_jobshop(const char *path, const char *format, int index, sa_timelag_jobshop *instance);
+void sa_free_timelag_jobshop(sa_timelag_jobshop *instance);
+
+// Single machine: processing time, weight and due date of each job
+// Formats: "wt40", "wt50", "wt100" (OR-Library files of 125 instances; index
+//          picks one, counted from 1, and each holds n times, n weights, n due dates)
+typedef struct {
+    int jobs;
+    int *p;
+    int *w;
+    int *d;
+} sa_single_machine;
+
+int sa_load_single_machine(const char *path, const char *format, int index, sa_single_machine *instance);
+void sa_free_single_machine(sa_single_machine *instance);
+
+// Resource-constrained project (PSPLIB single mode .sm or multi-mode .mm).
+// Activities include the dummy source and sink. The modes of activity a are
+// mode_start[a] .. mode_start[a + 1] - 1: mode m takes duration[m], holds
+// request[m * resources + r] of renewable resource r while it runs and uses
+// up consumption[m * nonrenewables + k] of the budget of nonrenewable
+// resource k. The successors of a are
+// successors[successor_start[a] .. successor_start[a + 1] - 1]; a file
+// whose precedence relations form a cycle is rejected.
+// A portfolio holds several projects sharing the renewable resources:
+// project p has activities project_start[p] .. project_start[p + 1] - 1,
+// each with its own source, sink and nonrenewable resources.
+// Formats: "psplib" (one .sm or .mm file)
+//          "portfolio" (the number of projects and of renewable resources,
+//          the capacities of the shared resources, then the path of each
+//          project's PSPLIB file, relative to the portfolio file)
+typedef struct {
+    int activities;
+    int resources;
+    int nonrenewables;
+    int projects;
+    int *project_start;
+    int *mode_start;
+    int *duration;
+    int *request;
+    int *consumption;
+    int *capacity;
+    int *budget;
+    int *successor_start;
+    int *successors;
+} sa_project;
+
+int sa_load_project(const char *path, const char *format, int index, sa_project *instance);
+void sa_free_project(sa_project *instance);
+
+// Flexible job shop (Brandimarte .fjs). Operations of job j are
+// job_start[j] .. job_start[j + 1] - 1 in order; operation o can run on
+// option_machine[i] (0-based) for option_time[i], i in option_start[o] .. option_start[o + 1] - 1.
+// Format: "brandimarte"
+typedef struct {
+    int jobs;
+    int machines;
+    int operations;
+    int *job_start;
+    int *option_start;
+    int *option_machine;
+    int *option_time;
+} sa_flexible_jobshop;
+
+int sa_load_flexible_jobshop(const char *path, const char *format, int index, sa_flexible_jobshop *instance);
+void sa_free_flexible_jobshop(sa_flexible_jobshop *instance);
+
+// Sequential ordering (TSPLIB .sop): cost[i * n + j] is the cost of going from
+// i to j; -1 means that j has to precede i
+// Format: "tsplib"
+typedef struct {
+    int n;
+    int *cost;
+} sa_sequencing;
+
+int sa_load_sequencing(const char *path, const char *format, int index, sa_sequencing *instance);
+void sa_free_sequencing(sa_sequencing *instance);
+
+#endif
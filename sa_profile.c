@@ -0,0 +1,122 @@
+// Resource profiles for schedule generation
+#include <stdlib.h>
+#include "sa_profile.h"
+
+int sa_profile_init(sa_profile *profile, int resources, int horizon, const int *capacity) {
+    int size = 1;
+    while (size < horizon) {
+        size *= 2;
+    }
+    profile->resources = resources;
+    profile->size = size;
+    profile->low = malloc((size_t)2 * size * resources * sizeof(int));
+    profile->add = malloc((size_t)2 * size * resources * sizeof(int));
+    if (profile->low == NULL || profile->add == NULL) {
+        sa_profile_free(profile);
+        return -1;
+    }
+    // Node 1 is the root and the children of node k are 2k and 2k + 1; the
+    // whole capacity sits at the leaves
+    for (int node = 1; node < 2 * size; node++) {
+        for (int r = 0; r < resources; r++) {
+            profile->low[node * resources + r] = capacity[r];
+            profile->add[node * resources + r] = node >= size ? capacity[r] : 0;
+        }
+    }
+    return 0;
+}
+
+// Add delta times the request to the free capacity over [first, last],
+// bottom up: the range is covered by at most two nodes per level, found by
+// walking in from its ends. The minimums of the ancestors of both ends are
+// then refreshed from their children.
+static void update(sa_profile *profile, const int *request, int first, int last, int delta) {
+    int k = profile->resources, *low = profile->low, *add = profile->add;
+    int left = first + profile->size, right = last + profile->size + 1;
+    for (int l = left, r = right; l < r; l /= 2, r /= 2) {
+        if (l & 1) {
+            for (int j = 0; j < k; j++) {
+                low[l * k + j] += delta * request[j];
+                add[l * k + j] += delta * request[j];
+            }
+            l++;
+        }
+        if (r & 1) {
+            --r;
+            for (int j = 0; j < k; j++) {
+                low[r * k + j] += delta * request[j];
+                add[r * k + j] += delta * request[j];
+            }
+        }
+    }
+    for (int end = 0; end < 2; end++) {
+        for (int node = (end == 0 ? left : right - 1) / 2; node >= 1; node /= 2) {
+            for (int j = 0; j < k; j++) {
+                int a = low[2 * node * k + j], b = low[(2 * node + 1) * k + j];
+                low[node * k + j] = add[node * k + j] + (a < b ? a : b);
+            }
+        }
+    }
+}
+
+// Last time in [first, last] within the range [from, to] of node at which
+// some resource has less free capacity than need, need being the request
+// less what the ancestors of node add; -1 if there is none. Every resource is
+// searched in the same walk, so one jump of sa_profile_earliest costs one
+// descent whatever the number of resources.
+static int last_short(const sa_profile *profile, int node, int from, int to, int first, int last, const int *need) {
+    int k = profile->resources;
+    const int *low = &profile->low[node * k], *add = &profile->add[node * k];
+    int short_of = 0;
+    for (int j = 0; j < k; j++) {
+        short_of |= low[j] < need[j];
+    }
+    if (last < from || to < first || !short_of) {
+        return -1;
+    }
+    if (from == to) {
+        return from;
+    }
+    int below[k];
+    for (int j = 0; j < k; j++) {
+        below[j] = need[j] - add[j];
+    }
+    int middle = (from + to) / 2;
+    int time = last_short(profile, 2 * node + 1, middle + 1, to, first, last, below);
+    return time >= 0 ? time : last_short(profile, 2 * node, from, middle, first, last, below);
+}
+
+int sa_profile_earliest(const sa_profile *profile, const int *request, int duration, int from) {
+    if (duration == 0) {
+        return from;
+    }
+    // A start is ruled out by the latest time in its window short of some
+    // resource, and so is every start up to that time: jump past it
+    for (int start = from;;) {
+        int last = start + duration - 1 < profile->size ? start + duration - 1 : profile->size - 1;
+        int blocked = last_short(profile, 1, 0, profile->size - 1, start, last, request);
+        if (blocked < 0) {
+            return start;
+        }
+        start = blocked + 1;
+    }
+}
+
+void sa_profile_reserve(sa_profile *profile, const int *request, int start, int duration) {
+    if (duration > 0) {
+        update(profile, request, start, start + duration - 1, -1);
+    }
+}
+
+void sa_profile_release(sa_profile *profile, const int *request, int start, int duration) {
+    if (duration > 0) {
+        update(profile, request, start, start + duration - 1, 1);
+    }
+}
+
+void sa_profile_free(sa_profile *profile) {
+    free(profile->low);
+    free(profile->add);
+    profile->low = NULL;
+    profile->add = NULL;
+}
@@ -0,0 +1,36 @@
+// Resource profiles for schedule generation
+#ifndef SA_PROFILE_H
+#define SA_PROFILE_H
+
+// Free capacity of every resource over the time units [0, horizon) in a
+// segment tree, the values of all resources side by side in each node:
+// low[node * resources + r] is the least free capacity of resource r over the
+// range of node, counting the amounts added to the node itself (add) but not
+// those added to its ancestors. Reserving or releasing an interval takes
+// O(log horizon), and finding the earliest start of an activity O(log
+// horizon) per change of the profile it skips over, however long the horizon
+// and the durations are.
+typedef struct {
+    int resources;
+    int size;   // Leaves of each tree, a power of two of at least horizon
+    int *low;
+    int *add;
+} sa_profile;
+
+// Profile with the whole capacity of each resource free; the horizon must
+// cover the end of every activity reserved (the sum of the durations does
+// for a serial schedule generation). Returns 0 on success.
+int sa_profile_init(sa_profile *profile, int resources, int horizon, const int *capacity);
+
+// Earliest start from time from at which request[r] units of every resource
+// r stay free for duration time units. The requests must fit the capacities.
+int sa_profile_earliest(const sa_profile *profile, const int *request, int duration, int from);
+
+// Take request[r] units of every resource r over [start, start + duration),
+// or give them back
+void sa_profile_reserve(sa_profile *profile, const int *request, int start, int duration);
+void sa_profile_release(sa_profile *profile, const int *request, int start, int duration);
+
+void sa_profile_free(sa_profile *profile);
+
+#endif
@@ -0,0 +1,42 @@
+// Random number generator for annealing chains (xoshiro256**)
+#include "sa_rng.h"
+
+// splitmix64, used to expand a 64-bit seed into the generator state
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void sa_rng_seed(sa_rng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+void sa_rng_jump(sa_rng *rng) {
+    static const uint64_t jump[] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    uint64_t s[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & (1ULL << b)) {
+                for (int k = 0; k < 4; k++) {
+                    s[k] ^= rng->s[k];
+                }
+            }
+            sa_rng_next(rng);
+        }
+    }
+    for (int k = 0; k < 4; k++) {
+        rng->s[k] = s[k];
+    }
+}
+
+void sa_rng_split(sa_rng *rng, sa_rng *child) {
+    *child = *rng;
+    sa_rng_jump(rng);
+}
@@ -0,0 +1,60 @@
+// Random number generator for annealing chains (xoshiro256**)
+#ifndef SA_RNG_H
+#define SA_RNG_H
+
+#include <stdint.h>
+
+// Generator state; each chain owns one, so no hidden global state is shared
+typedef struct {
+    uint64_t s[4];
+} sa_rng;
+
+// Seed a generator (the seed is expanded with splitmix64)
+void sa_rng_seed(sa_rng *rng, uint64_t seed);
+
+// Advance the generator by 2^128 draws
+void sa_rng_jump(sa_rng *rng);
+
+// Hand the current stream to child and move rng on to the next,
+// non-overlapping stream
+void sa_rng_split(sa_rng *rng, sa_rng *child);
+
+static inline uint64_t sa_rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Next 64 random bits
+static inline uint64_t sa_rng_next(sa_rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = sa_rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = sa_rng_rotl(s[3], 45);
+    return result;
+}
+
+// Uniform integer in [0, n) without modulo bias (Lemire's method), n > 0
+static inline int sa_rng_below(sa_rng *rng, int n) {
+    uint32_t range = (uint32_t)n;
+    uint64_t product = (sa_rng_next(rng) >> 32) * range;
+    uint32_t low = (uint32_t)product;
+    if (low < range) {
+        uint32_t threshold = -range % range;
+        while (low < threshold) {
+            product = (sa_rng_next(rng) >> 32) * range;
+            low = (uint32_t)product;
+        }
+    }
+    return (int)(product >> 32);
+}
+
+// Uniform double in [0, 1)
+static inline double sa_rng_uniform(sa_rng *rng) {
+    return (sa_rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+#endif
@@ -0,0 +1,132 @@
+// Annealing telemetry: per-step records written to a file in the background
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "sa_trace.h"
+
+// Records per ring (a power of two); a full ring drops records rather than
+// stall the chain
+#define RING_CAPACITY 16384
+
+// Single-producer single-consumer ring: the chain advances head, the writer
+// advances tail. They sit on separate cache lines so the two threads do not
+// invalidate each other's counters.
+typedef struct {
+    _Alignas(64) atomic_size_t head;
+    long dropped;
+    _Alignas(64) atomic_size_t tail;
+    sa_trace_record *records;
+} ring;
+
+struct sa_trace {
+    FILE *out;
+    int binary;
+    int chains;
+    ring *rings;
+    atomic_int stop;
+    pthread_t writer;
+};
+
+static void write_record(sa_trace *trace, const sa_trace_record *record) {
+    if (trace->binary) {
+        fwrite(record, sizeof(*record), 1, trace->out);
+        return;
+    }
+    double acceptance = record->moves > 0 ? (double)record->accepted / record->moves : 0.0;
+    fprintf(trace->out, "%d,%ld,%.6g,%ld,%ld,%.4f,%.17g,%.17g,%ld,%.1f\n", record->chain, record->step,
+            record->temperature, record->moves, record->accepted, acceptance, record->current_cost,
+            record->best_cost, record->evaluations, record->ns_per_evaluation);
+}
+
+// Write every record queued so far; returns the number written
+static size_t drain(sa_trace *trace) {
+    size_t written = 0;
+    for (int k = 0; k < trace->chains; k++) {
+        ring *r = &trace->rings[k];
+        size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+        for (; tail != head; tail++) {
+            write_record(trace, &r->records[tail % RING_CAPACITY]);
+            written++;
+        }
+        atomic_store_explicit(&r->tail, tail, memory_order_release);
+    }
+    return written;
+}
+
+// Writer thread: drain the rings, sleeping while they are empty
+static void *run_writer(void *arg) {
+    sa_trace *trace = arg;
+    const struct timespec pause = {0, 200000};
+    while (!atomic_load_explicit(&trace->stop, memory_order_acquire)) {
+        if (drain(trace) == 0) {
+            nanosleep(&pause, NULL);
+        }
+    }
+    drain(trace);
+    return NULL;
+}
+
+// Check whether path ends with suffix
+static int ends_with(const char *path, const char *suffix) {
+    size_t length = strlen(path), suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(path + length - suffix_length, suffix) == 0;
+}
+
+sa_trace *sa_trace_open(const char *path, int chains) {
+    int binary = ends_with(path, ".bin");
+    FILE *out = fopen(path, binary ? "wb" : "w");
+    if (out == NULL) {
+        perror(path);
+        return NULL;
+    }
+    sa_trace *trace = malloc(sizeof(sa_trace));
+    trace->out = out;
+    trace->binary = binary;
+    trace->chains = chains;
+    trace->rings = aligned_alloc(64, chains * sizeof(ring));
+    for (int k = 0; k < chains; k++) {
+        atomic_init(&trace->rings[k].head, 0);
+        atomic_init(&trace->rings[k].tail, 0);
+        trace->rings[k].dropped = 0;
+        trace->rings[k].records = malloc(RING_CAPACITY * sizeof(sa_trace_record));
+    }
+    atomic_init(&trace->stop, 0);
+    if (!binary) {
+        fprintf(out, "chain,step,temperature,moves,accepted,acceptance,current_cost,best_cost,"
+                     "evaluations,ns_per_evaluation\n");
+    }
+    pthread_create(&trace->writer, NULL, run_writer, trace);
+    return trace;
+}
+
+void sa_trace_push(sa_trace *trace, const sa_trace_record *record) {
+    ring *r = &trace->rings[record->chain];
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail == RING_CAPACITY) {
+        r->dropped++;
+        return;
+    }
+    r->records[head % RING_CAPACITY] = *record;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+void sa_trace_close(sa_trace *trace) {
+    atomic_store_explicit(&trace->stop, 1, memory_order_release);
+    pthread_join(trace->writer, NULL);
+    long dropped = 0;
+    for (int k = 0; k < trace->chains; k++) {
+        dropped += trace->rings[k].dropped;
+        free(trace->rings[k].records);
+    }
+    if (dropped > 0) {
+        fprintf(stderr, "Trace: %ld records dropped (writer fell behind)\n", dropped);
+    }
+    fclose(trace->out);
+    free(trace->rings);
+    free(trace);
+}
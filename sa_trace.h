@@ -0,0 +1,35 @@
+// Annealing telemetry: per-step records written to a file in the background
+#ifndef SA_TRACE_H
+#define SA_TRACE_H
+
+// Statistics of one chain over one temperature step (one exchange round for
+// replicas). Binary traces are a plain array of these records.
+typedef struct {
+    int chain;                // Chain or replica index
+    int reserved;
+    long step;                // Temperature step within the chain, from 0
+    double temperature;
+    long moves;               // Moves tried during the step
+    long accepted;            // Moves accepted during the step
+    double current_cost;      // Cost at the end of the step
+    double best_cost;         // Best cost of the chain so far
+    long evaluations;         // Evaluations since the chain started
+    double ns_per_evaluation; // Wall-clock time of the step per evaluation
+} sa_trace_record;
+
+typedef struct sa_trace sa_trace;
+
+// Open a trace with one preallocated ring per chain and start the thread that
+// drains the rings into path: raw records when path ends in .bin, CSV
+// otherwise. Returns NULL (after printing the error) if path cannot be opened.
+sa_trace *sa_trace_open(const char *path, int chains);
+
+// Queue a record from the thread that runs record->chain. Never blocks or
+// allocates: when the ring is full the record is dropped and counted.
+void sa_trace_push(sa_trace *trace, const sa_trace_record *record);
+
+// Write the remaining records, stop the writer thread and close the file;
+// reports dropped records on stderr
+void sa_trace_close(sa_trace *trace);
+
+#endif